@@ -19,16 +19,32 @@ SIMILARITY_THRESHOLD = 0.75  # Voice authentication threshold (0.0-1.0)
 # Lower values = more lenient authentication
 
 # Audio Processing Settings
-RECORDING_DURATION = 3  # Recording duration in seconds
+RECORDING_DURATION = 3  # Recording duration in seconds (window mode)
 NOISE_THRESHOLD = 0.02  # RMS threshold for noise filtering
 # 0.01 = Very sensitive (captures whispers, may capture noise)
 # 0.05 = Medium (normal speech)
 # 0.10 = Low sensitivity (requires loud speech)
 # 0.03-0.04 = Recommended for noisy environments
 
+# Capture Settings
+CAPTURE_MODE = "stream"  # "stream": continuous capture, utterances end at speech endpoints
+                         # "window": fixed RECORDING_DURATION recordings
+STREAM_BLOCK_MS = 100  # Audio fed to the recognizer per step in stream mode
+MAX_UTTERANCE_SECONDS = 10  # Audio kept per utterance for authentication
+INCREMENTAL_AUTH = True  # Stream mode: authenticate while the user is still speaking
+
+# Pipeline Settings
+PIPELINED_MODE = True  # Run voice authentication and speech recognition in parallel
+
+# Speech Daemon Settings
+USE_SPEECH_DAEMON = False  # Use models kept resident by speech_daemon.py (falls back to local loading)
+SPEECH_DAEMON_SOCKET = "/tmp/robot_speech/speech.sock"
+
 # Model Paths
 MODEL_PATH = "model"  # Path to Vosk model directory
 SIGNATURE_FILE = "owner_voice_signature.npy"  # Voice signature file
+SPEAKER_DB_DIR = "speaker_db"  # Multi-user speaker database (used instead of SIGNATURE_FILE if present)
+PERMISSIONS_FILE = "permissions.json"  # Speaker -> allowed command codes (hot-reloaded; without it all commands are allowed)
 
 # Sample Rate (typically 16000 for Resemblyzer and Vosk)
 SAMPLE_RATE = 16000
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../../include/portaudio.h"
+#include "audio_ring.h"
+
+// --- CAPTURE STATISTICS ---
+// Updated by the callback thread, read by anyone.
+struct CaptureStats {
+    std::atomic<uint64_t> callbacks{0};
+    std::atomic<uint64_t> overruns{0};        // Callbacks where the ring was full
+    std::atomic<uint64_t> dropped_samples{0}; // Samples lost because the ring was full
+    std::atomic<uint64_t> input_overflows{0}; // PortAudio reported paInputOverflow
+    std::atomic<size_t> high_water{0};        // Max ring fill level seen (samples)
+    std::atomic<int64_t> last_callback_ns{0}; // Steady clock time of the newest samples
+};
+
+// --- CALLBACK CAPTURE ---
+struct AudioCapture {
+    explicit AudioCapture(size_t ring_samples) : ring(ring_samples) {}
+
+    AudioRing ring;
+    CaptureStats stats;
+    PaStream* stream = nullptr;
+};
+
+// PortAudio callback: only copies into the ring and updates counters.
+inline int capture_callback(const void* input, void* /*output*/, unsigned long frame_count,
+                           const PaStreamCallbackTimeInfo* /*time_info*/,
+                           PaStreamCallbackFlags status_flags, void* user_data) {
+    AudioCapture* cap = static_cast<AudioCapture*>(user_data);
+    cap->stats.callbacks.fetch_add(1, std::memory_order_relaxed);
+
+    if (status_flags & paInputOverflow) {
+        cap->stats.input_overflows.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (input == nullptr) return paContinue;
+
+    size_t written = cap->ring.write(static_cast<const int16_t*>(input), frame_count);
+    if (written < frame_count) {
+        cap->stats.overruns.fetch_add(1, std::memory_order_relaxed);
+        cap->stats.dropped_samples.fetch_add(frame_count - written, std::memory_order_relaxed);
+    }
+
+    cap->stats.last_callback_ns.store(monotonic_ns(), std::memory_order_relaxed);
+
+    size_t fill = cap->ring.available();
+    if (fill > cap->stats.high_water.load(std::memory_order_relaxed)) {
+        cap->stats.high_water.store(fill, std::memory_order_relaxed);
+    }
+    return paContinue;
+}
+
+// Opens the default input device (mono, int16) in callback mode.
+inline PaError capture_open(AudioCapture& cap, double sample_rate, unsigned long frames_per_buffer) {
+    return Pa_OpenDefaultStream(&cap.stream,
+                                1,          // Input channel (Mono)
+                                0,          // Output channel (None)
+                                paInt16,    // Format (16 bit integer)
+                                sample_rate,
+                                frames_per_buffer,
+                                capture_callback,
+                                &cap);
+}
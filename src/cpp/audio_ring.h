@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Steady clock time in ns; timestamps audio as it is captured or received
+inline int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- LOCK-FREE AUDIO RING ---
+// Single-producer/single-consumer ring of int16 samples.
+// Producer: PortAudio callback thread (or a socket reader). Consumer: decoder thread.
+// No locks and no allocation after construction, so it is safe to use
+// from the real-time audio callback.
+class AudioRing {
+public:
+    explicit AudioRing(size_t min_capacity) {
+        size_t cap = 1;
+        while (cap < min_capacity) cap <<= 1; // Power of two -> index with a mask
+        buffer_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    size_t capacity() const { return buffer_.size(); }
+
+    // Samples ready to be read (consumer side view)
+    size_t available() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    // Producer: copies as many samples as fit, returns the number written
+    size_t write(const int16_t* data, size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t space = capacity() - (head - tail);
+        if (count > space) count = space;
+
+        size_t start = head & mask_;
+        size_t first = count < capacity() - start ? count : capacity() - start;
+        memcpy(&buffer_[start], data, first * sizeof(int16_t));
+        memcpy(&buffer_[0], data + first, (count - first) * sizeof(int16_t));
+
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer: copies up to count samples into out, returns the number read
+    size_t read(int16_t* out, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t ready = head - tail;
+        if (count > ready) count = ready;
+
+        size_t start = tail & mask_;
+        size_t first = count < capacity() - start ? count : capacity() - start;
+        memcpy(out, &buffer_[start], first * sizeof(int16_t));
+        memcpy(out + first, &buffer_[0], (count - first) * sizeof(int16_t));
+
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer: drops up to count of the oldest samples, returns the number dropped
+    size_t discard(size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t ready = head_.load(std::memory_order_acquire) - tail;
+        if (count > ready) count = ready;
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<int16_t> buffer_;
+    size_t mask_ = 0;
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> head_{0}; // Written only by producer
+    alignas(64) std::atomic<size_t> tail_{0}; // Written only by consumer
+};
@@ -0,0 +1,127 @@
+// Bulk transcription of recorded command sessions.
+//
+// Transcribes every 16 kHz mono 16-bit WAV under a directory with
+// BatchTranscriber (batch_transcriber.h): VoskBatchModel when built with
+// -DVOSK_GPU_BATCH, otherwise one recognizer per thread on a shared model.
+// Used to re-score field logs with a new model and as a command-accuracy
+// regression run; the expected command of each file comes from --labels or
+// its file name, as in replay_bench.cpp.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vosk_api.h>
+#include "batch_transcriber.h"
+#include "command_matcher.h"
+#include "wav_dataset.h"
+
+#define MODEL_PATH "../../model"
+
+// Command the live front-end would have sent: the first utterance that
+// holds one (later ones would be separate commands)
+char first_command(const Transcript& t) {
+    for (const std::string& segment : t.segments) {
+        char command = match_command(segment).command;
+        if (command != 0) return command;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    size_t parallel = std::max(1u, std::thread::hardware_concurrency());
+    std::string model_path = MODEL_PATH;
+    std::string labels_path;
+    std::string tsv_path;
+    std::string wav_dir;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--parallel") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            parallel = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "--labels") == 0 && i + 1 < argc) {
+            labels_path = argv[++i];
+        } else if (strcmp(argv[i], "--tsv") == 0 && i + 1 < argc) {
+            tsv_path = argv[++i];
+        } else if (argv[i][0] != '-' && wav_dir.empty()) {
+            wav_dir = argv[i];
+        } else {
+            wav_dir.clear();
+            break;
+        }
+    }
+    if (wav_dir.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <wav_dir> [--parallel N] [--model DIR] [--labels FILE] [--tsv FILE]"
+                  << std::endl;
+        std::cerr << "  --parallel N       Streams per batch (GPU) or threads (CPU), default: one per CPU"
+                  << std::endl;
+        std::cerr << "  --tsv FILE         Write file, expected, sent and text per file" << std::endl;
+        return -1;
+    }
+
+    std::error_code ec;
+    std::vector<std::string> files = list_wav_files(wav_dir, ec);
+    if (ec || files.empty()) {
+        std::cerr << "ERROR: no .wav files in '" << wav_dir << "'" << (ec ? ": " + ec.message() : "") << std::endl;
+        return -1;
+    }
+    std::map<std::string, std::string> labels;
+    if (!labels_path.empty()) labels = load_labels(labels_path);
+
+    vosk_set_log_level(-1);
+    BatchTranscriber transcriber(model_path.c_str(), parallel);
+    if (!transcriber.ok()) {
+        std::cerr << "ERROR: '" << model_path << "' directory not found or model is invalid!" << std::endl;
+        return -1;
+    }
+    std::cout << "Transcribing " << files.size() << " files: " << BatchTranscriber::backend() << ", parallel "
+              << parallel << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Transcript> transcripts = transcriber.run(files);
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream tsv;
+    if (!tsv_path.empty()) {
+        tsv.open(tsv_path);
+        tsv << "file\texpected\tsent\ttext\n";
+    }
+
+    CommandScore score;
+    double audio_s = 0.0;
+    size_t failed = 0;
+    for (const Transcript& t : transcripts) {
+        if (!t.ok) {
+            std::cerr << "Skipping " << t.path << ": " << t.error << std::endl;
+            failed++;
+            continue;
+        }
+        char expected = expected_command(t.path, labels);
+        char sent = first_command(t);
+        score.add(expected, sent);
+        audio_s += t.audio_seconds;
+
+        std::string text = t.text();
+        if (expected != sent) {
+            // Only the mismatches; the TSV has every file
+            std::cout << t.path << ": expected " << command_label(expected) << ", sent " << command_label(sent)
+                      << " \"" << text << "\"" << std::endl;
+        }
+        if (tsv.is_open()) {
+            tsv << t.path << '\t' << command_label(expected) << '\t' << command_label(sent) << '\t' << text << '\n';
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\nFiles: " << transcripts.size() - failed << " transcribed, " << failed << " skipped" << std::endl;
+    std::cout << "Audio: " << audio_s << " s in " << wall_s << " s wall ("
+              << (wall_s > 0 ? audio_s / wall_s : 0.0) << "x real time)" << std::endl;
+    score.print(std::cout);
+    return 0;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <vosk_api.h>
+#include "command_matcher.h"
+#include "wav_dataset.h"
+
+// --- BULK TRANSCRIPTION ---
+// Transcribes many recorded sessions (WAV files) at once, for re-scoring
+// field logs and command-accuracy regression runs. Two backends with the
+// same interface, chosen at compile time:
+//
+//  -DVOSK_GPU_BATCH  VoskBatchModel / VoskBatchRecognizer (needs a CUDA
+//                    build of libvosk). Up to `parallel` files are open as
+//                    batch streams at once; every round feeds one chunk of
+//                    each, vosk_batch_model_wait() lets Vosk's dynamic batcher
+//                    decode them together, and finished streams are replaced
+//                    by the next file.
+//  (default)         CPU: one shared VoskModel and `parallel` threads, each
+//                    with its own VoskRecognizer, taking the next file from
+//                    a shared counter.
+#define BATCH_CHUNK_FRAMES 8000 // 500 ms of audio per feed
+
+struct Transcript {
+    std::string path;
+    bool ok = false;
+    std::string error;                 // Why the file was not transcribed
+    double audio_seconds = 0.0;
+    std::vector<std::string> segments; // Text of each result (utterance), in order
+
+    std::string text() const {
+        std::string joined;
+        for (const std::string& s : segments) {
+            if (!joined.empty()) joined += ' ';
+            joined += s;
+        }
+        return joined;
+    }
+};
+
+// Appends the "text" of one Vosk result JSON, skipping empty results
+inline void add_segment(Transcript& t, const char* json) {
+    std::string_view text = json_string_field(json, "text");
+    if (!text.empty()) t.segments.emplace_back(text);
+}
+
+inline bool load_transcript_audio(Transcript& t, std::vector<int16_t>& samples) {
+    samples.clear();
+    t.ok = read_wav(t.path, samples, t.error);
+    t.audio_seconds = (double)samples.size() / WAV_SAMPLE_RATE;
+    return t.ok;
+}
+
+#ifdef VOSK_GPU_BATCH
+
+class BatchTranscriber {
+public:
+    BatchTranscriber(const char* model_path, size_t parallel)
+        : model_(vosk_batch_model_new(model_path)), parallel_(std::max<size_t>(1, parallel)) {}
+
+    ~BatchTranscriber() {
+        if (model_ != nullptr) vosk_batch_model_free(model_);
+    }
+
+    bool ok() const { return model_ != nullptr; }
+    static const char* backend() { return "VoskBatchModel"; }
+
+    std::vector<Transcript> run(const std::vector<std::string>& paths) {
+        std::vector<Transcript> out(paths.size());
+        std::vector<Slot> active;
+        size_t next = 0;
+
+        while (next < paths.size() || !active.empty()) {
+            // Dynamic batching: keep `parallel_` streams in flight
+            while (active.size() < parallel_ && next < paths.size()) {
+                Slot slot;
+                slot.job = next++;
+                out[slot.job].path = paths[slot.job];
+                if (!load_transcript_audio(out[slot.job], slot.samples)) continue;
+                slot.recognizer = vosk_batch_recognizer_new(model_, WAV_SAMPLE_RATE);
+                if (slot.recognizer == nullptr) {
+                    out[slot.job].ok = false;
+                    out[slot.job].error = "batch recognizer could not be created";
+                    continue;
+                }
+                active.push_back(std::move(slot));
+            }
+
+            for (Slot& slot : active) {
+                if (slot.finished) continue;
+                size_t frames = std::min<size_t>(BATCH_CHUNK_FRAMES, slot.samples.size() - slot.pos);
+                if (frames > 0) {
+                    vosk_batch_recognizer_accept_waveform(
+                        slot.recognizer, (const char*)&slot.samples[slot.pos], (int)frames * 2);
+                    slot.pos += frames;
+                }
+                if (slot.pos == slot.samples.size()) {
+                    vosk_batch_recognizer_finish_stream(slot.recognizer);
+                    slot.finished = true;
+                }
+            }
+
+            vosk_batch_model_wait(model_);
+
+            for (size_t i = 0; i < active.size();) {
+                Slot& slot = active[i];
+                drain(slot.recognizer, out[slot.job]);
+                if (slot.finished && vosk_batch_recognizer_get_pending_chunks(slot.recognizer) == 0) {
+                    drain(slot.recognizer, out[slot.job]);
+                    vosk_batch_recognizer_free(slot.recognizer);
+                    active[i] = std::move(active.back());
+                    active.pop_back();
+                } else {
+                    i++;
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    struct Slot {
+        size_t job = 0;
+        VoskBatchRecognizer* recognizer = nullptr;
+        std::vector<int16_t> samples;
+        size_t pos = 0;
+        bool finished = false; // finish_stream() called
+    };
+
+    static void drain(VoskBatchRecognizer* recognizer, Transcript& t) {
+        const char* json;
+        while ((json = vosk_batch_recognizer_front_result(recognizer)) != nullptr && *json != '\0') {
+            add_segment(t, json);
+            vosk_batch_recognizer_pop(recognizer);
+        }
+    }
+
+    VoskBatchModel* model_;
+    size_t parallel_;
+};
+
+#else // CPU fallback
+
+class BatchTranscriber {
+public:
+    BatchTranscriber(const char* model_path, size_t parallel)
+        : model_(vosk_model_new(model_path)), parallel_(std::max<size_t>(1, parallel)) {}
+
+    ~BatchTranscriber() {
+        if (model_ != nullptr) vosk_model_free(model_);
+    }
+
+    bool ok() const { return model_ != nullptr; }
+    static const char* backend() { return "thread-parallel CPU"; }
+
+    std::vector<Transcript> run(const std::vector<std::string>& paths) {
+        std::vector<Transcript> out(paths.size());
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> threads;
+        size_t count = std::min(parallel_, std::max<size_t>(1, paths.size()));
+        for (size_t i = 0; i < count; i++) {
+            threads.emplace_back([&]() {
+                VoskRecognizer* recognizer = vosk_recognizer_new(model_, WAV_SAMPLE_RATE);
+                std::vector<int16_t> samples;
+                size_t job;
+                while ((job = next.fetch_add(1, std::memory_order_relaxed)) < paths.size()) {
+                    Transcript& t = out[job];
+                    t.path = paths[job];
+                    if (recognizer == nullptr) {
+                        t.error = "recognizer could not be created";
+                        continue;
+                    }
+                    if (!load_transcript_audio(t, samples)) continue;
+                    transcribe(recognizer, samples, t);
+                }
+                if (recognizer != nullptr) vosk_recognizer_free(recognizer);
+            });
+        }
+        for (auto& t : threads) t.join();
+        return out;
+    }
+
+private:
+    static void transcribe(VoskRecognizer* recognizer, const std::vector<int16_t>& samples, Transcript& t) {
+        vosk_recognizer_reset(recognizer);
+        for (size_t pos = 0; pos < samples.size(); pos += BATCH_CHUNK_FRAMES) {
+            size_t frames = std::min<size_t>(BATCH_CHUNK_FRAMES, samples.size() - pos);
+            if (vosk_recognizer_accept_waveform(recognizer, (const char*)&samples[pos], (int)frames * 2) > 0) {
+                add_segment(t, vosk_recognizer_result(recognizer));
+            }
+        }
+        add_segment(t, vosk_recognizer_final_result(recognizer));
+    }
+
+    VoskModel* model_;
+    size_t parallel_;
+};
+
+#endif
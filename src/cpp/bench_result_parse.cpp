@@ -0,0 +1,219 @@
+// Microbenchmark: reading the command (and speaker vector) out of a Vosk
+// result with the code main.cpp has run over time.
+//
+//   baseline    the original process_result: copy the JSON into a
+//               std::string and search it for command substrings
+//   in-place    json_string_field + match_command, then parse_spk_vector as
+//               a second scan (the code before vosk_result.h)
+//   sax         SpeakerEvidence::parse (command_gate.h), as process_result
+//               runs it now: command word, confidence, n-best margin and
+//               speaker vector in one pass
+//
+// Inputs are shaped like real results: text only, with words
+// (vosk_recognizer_set_words), with 3 alternatives, and with words plus a
+// 128-value speaker vector. Allocations are counted by replacing global new.
+//
+// g++ -std=c++17 -O2 -o bench_result_parse bench_result_parse.cpp -I../../include
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "command_gate.h"
+#include "command_matcher.h"
+
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// --- INPUTS ---
+std::string word_json(const char* word, float conf, float start) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "{\n      \"conf\" : %.6f,\n      \"end\" : %.6f,\n      \"start\" : %.6f,\n"
+             "      \"word\" : \"%s\"\n    }", conf, start + 0.3f, start, word);
+    return buf;
+}
+
+std::string words_json(const char* const* words, size_t n) {
+    std::string out = "[";
+    for (size_t i = 0; i < n; i++) {
+        out += (i ? ", " : "") + word_json(words[i], 0.55f + 0.06f * (float)i, 0.4f * (float)i);
+    }
+    return out + "]";
+}
+
+std::string make_text_only() {
+    return "{\n  \"text\" : \"robot lütfen biraz ileri git sonra dur\"\n}";
+}
+
+std::string make_with_words() {
+    const char* words[] = {"robot", "lütfen", "biraz", "ileri", "git", "sonra", "dur"};
+    return "{\n  \"result\" : " + words_json(words, 7) +
+           ",\n  \"text\" : \"robot lütfen biraz ileri git sonra dur\"\n}";
+}
+
+std::string make_alternatives() {
+    const char* a[] = {"ileri", "git"};
+    const char* b[] = {"geri", "git"};
+    const char* c[] = {"ileri", "gitti"};
+    return "{\"alternatives\" : [{\"confidence\" : 231.402008, \"result\" : " + words_json(a, 2) +
+           ", \"text\" : \"ileri git\"}, {\"confidence\" : 228.117493, \"result\" : " + words_json(b, 2) +
+           ", \"text\" : \"geri git\"}, {\"confidence\" : 226.993103, \"result\" : " + words_json(c, 2) +
+           ", \"text\" : \"ileri gitti\"}]}";
+}
+
+std::string make_with_spk() {
+    const char* words[] = {"lütfen", "dur"};
+    std::string spk = "[";
+    for (int i = 0; i < 128; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%s%.6f", i ? ", " : "", (float)((i * 37) % 200 - 100) / 117.0f);
+        spk += buf;
+    }
+    return "{\n  \"result\" : " + words_json(words, 2) + ",\n  \"spk\" : " + spk +
+           "],\n  \"spk_frames\" : 212,\n  \"text\" : \"lütfen dur\"\n}";
+}
+
+// --- THE THREE APPROACHES ---
+struct Selected {
+    char command = 0;
+    float conf = -1.0f; // -1: not read
+    size_t spk = 0;     // Speaker vector values read
+};
+
+// baseline: process_result of the original main.cpp, verbatim apart from
+// returning the command instead of sending it. The whole JSON is copied and
+// searched; there is no word confidence and no speaker vector.
+Selected baseline(const char* json_result) {
+    Selected out;
+    std::string text(json_result);
+    if (text.empty()) return out;
+
+    if (text.find("kalk") != std::string::npos || text.find("ayağa") != std::string::npos) {
+        out.command = 'K';
+    }
+    else if (text.find("otur") != std::string::npos) {
+        out.command = 'O';
+    }
+    else if (text.find("ileri") != std::string::npos || text.find("git") != std::string::npos) {
+        if (text.find("geri") == std::string::npos) {
+             out.command = 'I';
+        }
+    }
+    else if (text.find("geri") != std::string::npos) {
+        out.command = 'G';
+    }
+    else if (text.find("takip") != std::string::npos || text.find("başla") != std::string::npos) {
+        out.command = '1';
+    }
+    else if (text.find("dur") != std::string::npos || text.find("bekle") != std::string::npos) {
+        out.command = '0';
+    }
+    return out;
+}
+
+// in-place: process_result before vosk_result.h, verbatim: "text" read in
+// place and matched, then (speaker verification) a second scan of the same
+// JSON for the "spk" array with strtof.
+size_t parse_spk_vector(const char* json, std::vector<float>& out) {
+    out.clear();
+    if (json == nullptr) return 0;
+    std::string_view s(json);
+
+    size_t pos = s.find("\"spk\"");
+    if (pos == std::string_view::npos) return 0;
+    pos = s.find('[', pos);
+    if (pos == std::string_view::npos) return 0;
+
+    const char* p = json + pos + 1;
+    while (true) {
+        while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' || *p == ',') p++;
+        if (*p == ']' || *p == '\0') break;
+        char* end = nullptr;
+        float v = strtof(p, &end);
+        if (end == p) break; // Malformed
+        out.push_back(v);
+        p = end;
+    }
+    return out.size();
+}
+
+std::vector<float> spk_scratch; // Reserved in main, like the verifier's buffer was
+
+Selected in_place(const char* json) {
+    Selected out;
+    out.command = match_command(json_string_field(json, "text")).command;
+    if (out.command != 0) out.spk = parse_spk_vector(json, spk_scratch);
+    return out;
+}
+
+// sax: what main.cpp's process_result runs now, one parse_vosk_result pass
+// for the command word with its confidence, the n-best margin and the
+// speaker vector
+SpeakerEvidence evidence;
+
+Selected sax(const char* json) {
+    Selected out;
+    out.command = evidence.parse(json);
+    out.conf = evidence.pick.word.conf;
+    out.spk = evidence.spk.size();
+    return out;
+}
+
+// --- TIMING ---
+template <class Fn>
+void run(const char* name, const std::string& json, Fn fn) {
+    const int warmup = 10000;
+    const int iterations = 200000;
+    volatile char sink = 0;
+    for (int i = 0; i < warmup; i++) sink ^= fn(json.c_str()).command;
+
+    size_t allocations = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) sink ^= fn(json.c_str()).command;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    allocations = g_allocations.load() - allocations;
+    (void)sink;
+
+    Selected r = fn(json.c_str());
+    std::cout << "  " << std::left << std::setw(11) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << ns / iterations << " ns/result" << std::setw(7) << std::setprecision(2)
+              << (double)allocations / iterations << " allocs"
+              << "   command=" << (r.command ? r.command : '-') << " conf=" << std::setprecision(3) << r.conf
+              << " spk=" << r.spk << std::endl;
+}
+
+int main() {
+    struct Input {
+        const char* name;
+        std::string json;
+    } inputs[] = {
+        {"text only", make_text_only()},
+        {"words", make_with_words()},
+        {"3 alternatives", make_alternatives()},
+        {"words + spk", make_with_spk()},
+    };
+
+    spk_scratch.reserve(128);
+    evidence.spk.reserve(128);
+
+    for (const Input& input : inputs) {
+        std::cout << input.name << " (" << input.json.size() << " bytes)" << std::endl;
+        run("baseline", input.json, baseline);
+        run("in-place", input.json, in_place);
+        run("sax", input.json, sax);
+    }
+    return 0;
+}
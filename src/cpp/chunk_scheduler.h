@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// --- ADAPTIVE CHUNK SIZING ---
+// Capture delivers small hardware periods into the ring; this decides how
+// many samples the decoder hands to Vosk per call. Small chunks mean audio
+// reaches the decoder sooner; large chunks amortize per-call overhead when
+// the decoder is falling behind.
+//
+// Fixed mode always returns the same size. Adaptive mode doubles the chunk
+// when decoding is slower than GROW_LOAD of real time or a backlog builds up,
+// and halves it after SHRINK_AFTER consecutive chunks decoded with load under
+// SHRINK_LOAD and no backlog.
+class ChunkScheduler {
+public:
+    static constexpr double GROW_LOAD = 0.8;
+    static constexpr double SHRINK_LOAD = 0.3;
+    static constexpr int SHRINK_AFTER = 4;
+
+    // Sizes are in frames and rounded to whole capture periods
+    ChunkScheduler(size_t period_frames, size_t min_frames, size_t max_frames, bool adaptive)
+        : period_(period_frames),
+          min_(round_to_period(min_frames)),
+          max_(std::max(round_to_period(max_frames), round_to_period(min_frames))),
+          current_(adaptive ? min_ : max_),
+          adaptive_(adaptive) {}
+
+    size_t next_chunk() const { return current_; }
+    size_t max_chunk() const { return max_; }
+    bool adaptive() const { return adaptive_; }
+
+    // Feed back how long the last chunk took to decode and how many frames
+    // were still waiting in the ring afterwards
+    void on_decoded(size_t frames, double decode_seconds, double sample_rate, size_t backlog_frames) {
+        if (!adaptive_ || frames == 0) return;
+
+        double load = decode_seconds / (frames / sample_rate);
+        if (load > GROW_LOAD || backlog_frames > current_) {
+            current_ = std::min(current_ * 2, max_);
+            idle_chunks_ = 0;
+        } else if (load < SHRINK_LOAD && backlog_frames < period_) {
+            if (++idle_chunks_ >= SHRINK_AFTER) {
+                current_ = std::max(round_to_period(current_ / 2), min_);
+                idle_chunks_ = 0;
+            }
+        } else {
+            idle_chunks_ = 0;
+        }
+    }
+
+private:
+    size_t round_to_period(size_t frames) const {
+        size_t periods = (frames + period_ - 1) / period_;
+        return std::max<size_t>(periods, 1) * period_;
+    }
+
+    size_t period_;
+    size_t min_;
+    size_t max_;
+    size_t current_;
+    bool adaptive_;
+    int idle_chunks_ = 0;
+};
+
+// --- MIC-TO-DECODER LATENCY ---
+// Accumulates per-chunk latency (seconds) for the exit summary.
+struct LatencyStats {
+    uint64_t chunks = 0;
+    double sum = 0.0;
+    double max = 0.0;
+
+    void add(double seconds) {
+        chunks++;
+        sum += seconds;
+        max = std::max(max, seconds);
+    }
+
+    double mean() const { return chunks ? sum / chunks : 0.0; }
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "command_matcher.h"
+#include "vosk_result.h"
+
+// --- CONFIDENCE THRESHOLDS ---
+// A command is only sent when the decoder is sure enough of it; a wrongly
+// executed movement costs far more than asking again. Two kinds of evidence:
+//   min_conf    posterior of the command word, 0..1
+//               (vosk_recognizer_set_words, --confidence)
+//   min_margin  n-best score of the best alternative minus the best one that
+//               holds a different command (vosk_recognizer_set_max_alternatives,
+//               --nbest N); Vosk's alternative "confidence" is a lattice score,
+//               so this is in score units, not 0..1
+// Stop is never held back.
+struct CommandThreshold {
+    char command;
+    float min_conf;
+    float min_margin;
+};
+
+constexpr CommandThreshold kCommandThresholds[] = {
+    {'0', 0.00f, 0.0f}, // Stop (safety: always sent)
+    {'H', 0.50f, 2.0f}, // Greeting
+    {'K', 0.70f, 4.0f}, // Stand up
+    {'O', 0.70f, 4.0f}, // Sit down
+    {'I', 0.80f, 6.0f}, // Forward
+    {'G', 0.80f, 6.0f}, // Backward
+    {'1', 0.80f, 6.0f}, // Follow
+};
+
+constexpr CommandThreshold kDefaultThreshold = {0, 0.80f, 6.0f};
+
+constexpr const CommandThreshold& command_threshold(char command) {
+    for (const CommandThreshold& t : kCommandThresholds) {
+        if (t.command == command) return t;
+    }
+    return kDefaultThreshold;
+}
+
+static_assert(command_threshold('0').min_conf == 0.0f, "Stop must never be gated");
+
+// --- COMMAND EVIDENCE FROM A RESULT ---
+// Command, word confidence and n-best margin from one parse of a final
+// result, with or without word lists and alternatives.
+struct CommandEvidence : VoskResultVisitor {
+    std::string_view text;      // Best alternative's text when there are alternatives
+    CommandPick pick;           // pick.word.conf is -1 without a word list
+    float margin = INFINITY;    // INFINITY: no alternatives, or none disagrees
+    size_t alternatives = 0;
+
+    void on_text(std::string_view t) { text = t; }
+    void on_word(const VoskWord& w) { pick.add(w); }
+    void on_alternative_word(size_t, const VoskWord& w) { current_.add(w); }
+
+    void on_alternative(size_t index, float confidence, std::string_view alternative_text) {
+        if (current_.words == 0) current_.from_text(alternative_text);
+        if (index == 0) {
+            pick = current_;
+            text = alternative_text;
+            best_score_ = confidence;
+        } else if (std::isinf(margin) && current_.command != pick.command) {
+            margin = best_score_ - confidence; // Runner-up that would do something else
+        }
+        alternatives++;
+        current_ = CommandPick();
+    }
+
+    char command() const { return pick.command; }
+
+    // Parses json; returns the command (0 if none)
+    char parse(const char* json) { return parse_as(*this, json); }
+
+protected:
+    // One parse_vosk_result pass with self (this object, or a handler
+    // derived from it) receiving the callbacks
+    template <class Self>
+    static char parse_as(Self& self, const char* json) {
+        CommandEvidence& e = self;
+        e = CommandEvidence();
+        parse_vosk_result(json, self);
+        if (e.pick.words == 0 && e.alternatives == 0 && !e.text.empty()) e.pick.from_text(e.text);
+        return e.pick.command;
+    }
+
+private:
+    CommandPick current_; // Alternative being read
+    float best_score_ = 0.0f;
+};
+
+// Also collects the speaker x-vector ("spk", with a speaker model attached)
+// in the same pass. spk keeps its capacity, so once reserved no result
+// allocates.
+struct SpeakerEvidence : CommandEvidence {
+    static constexpr bool wants_spk = true;
+    std::vector<float> spk; // Empty if the result has no speaker vector
+
+    void on_spk_value(float v) { spk.push_back(v); }
+
+    char parse(const char* json) {
+        spk.clear();
+        return parse_as(*this, json);
+    }
+};
+
+// --- RE-CONFIRMATION ---
+// Below its threshold a command is held and the user is asked to repeat it;
+// the same command again within CONFIRM_WINDOW_NS is sent. Any other
+// confident command replaces the pending one.
+#define CONFIRM_WINDOW_NS 4000000000LL // 4 s to repeat a held command
+
+struct GateStats {
+    uint64_t confident = 0; // Sent on the first utterance
+    uint64_t confirmed = 0; // Sent after a repeat
+    uint64_t held = 0;      // Re-confirmation requests
+};
+
+class ConfirmationGate {
+public:
+    enum class Decision { Send, Confirm };
+
+    const GateStats& stats() const { return stats_; }
+
+    // Forget a held command (statistics are kept)
+    void reset() { pending_ = 0; }
+
+    // True if the evidence clears the command's thresholds. Evidence the
+    // recognizer did not report (no word list / no alternatives) passes.
+    static bool is_confident(const CommandEvidence& e) {
+        const CommandThreshold& t = command_threshold(e.command());
+        if (e.pick.word.conf >= 0.0f && e.pick.word.conf < t.min_conf) return false;
+        return e.margin >= t.min_margin;
+    }
+
+    Decision check(const CommandEvidence& e, int64_t now_ns) {
+        if (is_confident(e)) {
+            pending_ = 0;
+            stats_.confident++;
+            return Decision::Send;
+        }
+        if (pending_ == e.command() && now_ns <= pending_deadline_ns_) {
+            pending_ = 0;
+            stats_.confirmed++;
+            return Decision::Send;
+        }
+        pending_ = e.command();
+        pending_deadline_ns_ = now_ns + CONFIRM_WINDOW_NS;
+        stats_.held++;
+        return Decision::Confirm;
+    }
+
+private:
+    char pending_ = 0;
+    int64_t pending_deadline_ns_ = 0;
+    GateStats stats_;
+};
+
+// --- FINAL RESULT TO COMMAND ---
+// The rules every front-end (main.cpp, stream_server.cpp, replay_bench.cpp)
+// applies to a parsed final result. gate is null without a confidence gate.
+enum class CommandVerdict {
+    None,        // No command word
+    AlreadySent, // Fired early from partials of the same utterance
+    Denied,      // Rejected by authorize
+    Confirm,     // Held by the gate until the user repeats it
+    Send
+};
+
+// authorize(evidence) -> bool runs for a command that would otherwise be
+// gated or sent (main.cpp: speaker verification); a denied command never
+// reaches the gate
+template <class Authorize>
+CommandVerdict command_verdict(const CommandEvidence& e, char already_sent, ConfirmationGate* gate, int64_t now_ns,
+                               Authorize&& authorize) {
+    if (e.command() == 0) return CommandVerdict::None;
+    if (e.command() == already_sent) return CommandVerdict::AlreadySent;
+    if (!authorize(e)) return CommandVerdict::Denied;
+    if (gate != nullptr && gate->check(e, now_ns) == ConfirmationGate::Decision::Confirm) {
+        return CommandVerdict::Confirm;
+    }
+    return CommandVerdict::Send;
+}
+
+inline CommandVerdict command_verdict(const CommandEvidence& e, char already_sent, ConfirmationGate* gate,
+                                      int64_t now_ns) {
+    return command_verdict(e, already_sent, gate, now_ns, [](const CommandEvidence&) { return true; });
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// --- COMMAND TABLE ---
+// Adding a command is a table edit: the lookup table and the recognizer
+// grammar are both generated from this list.
+struct CommandEntry {
+    std::string_view word; // Lowercase UTF-8 word as Vosk outputs it
+    char command;          // UDP command code understood by robot_main
+    int priority;          // Lower wins when one utterance holds several commands
+};
+
+constexpr CommandEntry kCommandTable[] = {
+    {"dur",   '0', 0}, // Stop beats everything else (safety)
+    {"bekle", '0', 0},
+    {"geri",  'G', 1}, // "geri git" means backward, so beat "git"
+    {"kalk",  'K', 2},
+    {"ayağa", 'K', 2},
+    {"otur",  'O', 2},
+    {"ileri", 'I', 2},
+    {"git",   'I', 2},
+    {"takip", '1', 2},
+    {"başla", '1', 2},
+    {"selam", 'H', 2},
+};
+constexpr size_t kCommandCount = sizeof(kCommandTable) / sizeof(kCommandTable[0]);
+
+// --- COMPILE-TIME PERFECT HASH ---
+// Seeded FNV-1a; a seed is searched at compile time so that every table word
+// lands in its own slot. A lookup is then one hash and one string compare.
+constexpr size_t kHashSlots = 32; // Power of two, > kCommandCount
+static_assert(kHashSlots > kCommandCount, "Grow kHashSlots");
+
+constexpr uint32_t command_hash(std::string_view word, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : word) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h & (kHashSlots - 1);
+}
+
+constexpr bool seed_is_perfect(uint32_t seed) {
+    bool used[kHashSlots] = {};
+    for (size_t i = 0; i < kCommandCount; i++) {
+        uint32_t slot = command_hash(kCommandTable[i].word, seed);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t find_perfect_seed() {
+    for (uint32_t seed = 0; seed < 100000; seed++) {
+        if (seed_is_perfect(seed)) return seed;
+    }
+    return UINT32_MAX;
+}
+
+constexpr uint32_t kHashSeed = find_perfect_seed();
+static_assert(kHashSeed != UINT32_MAX, "No perfect hash seed for kCommandTable");
+
+struct CommandSlots {
+    int8_t index[kHashSlots]; // Index into kCommandTable, -1 if empty
+};
+
+constexpr CommandSlots build_command_slots() {
+    CommandSlots slots = {};
+    for (size_t i = 0; i < kHashSlots; i++) slots.index[i] = -1;
+    for (size_t i = 0; i < kCommandCount; i++) {
+        slots.index[command_hash(kCommandTable[i].word, kHashSeed)] = static_cast<int8_t>(i);
+    }
+    return slots;
+}
+
+constexpr CommandSlots kCommandSlots = build_command_slots();
+
+// Returns the table entry for an exact word, or nullptr
+constexpr const CommandEntry* lookup_command(std::string_view word) {
+    int8_t i = kCommandSlots.index[command_hash(word, kHashSeed)];
+    if (i < 0 || kCommandTable[i].word != word) return nullptr;
+    return &kCommandTable[i];
+}
+
+static_assert(lookup_command("dur") && lookup_command("dur")->command == '0', "Table lookup broken");
+static_assert(lookup_command("durum") == nullptr, "Whole words only");
+
+// --- IN-PLACE JSON FIELD ACCESS ---
+// Returns the string value of a top-level key in a Vosk result
+// (e.g. "text" or "partial") as a view into json; empty if absent.
+// Vosk writes UTF-8 as-is, so the value needs no unescaping for matching.
+inline std::string_view json_string_field(const char* json, std::string_view key) {
+    if (json == nullptr) return {};
+    std::string_view s(json);
+
+    size_t pos = 0;
+    while ((pos = s.find(key, pos)) != std::string_view::npos) {
+        // Key must be quoted: "key"
+        size_t end = pos + key.size();
+        if (pos == 0 || s[pos - 1] != '"' || end >= s.size() || s[end] != '"') {
+            pos = end;
+            continue;
+        }
+        size_t i = end + 1;
+        while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) i++;
+        if (i >= s.size() || s[i] != ':') {
+            pos = end;
+            continue;
+        }
+        i++;
+        while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) i++;
+        if (i >= s.size() || s[i] != '"') return {};
+
+        size_t start = ++i;
+        while (i < s.size() && s[i] != '"') {
+            i += (s[i] == '\\') ? 2 : 1;
+        }
+        if (i > s.size()) i = s.size();
+        return s.substr(start, i - start);
+    }
+    return {};
+}
+
+// --- MATCHER ---
+struct CommandMatch {
+    char command = 0;       // 0 if nothing matched
+    std::string_view span;  // Matched word, points into the input text
+};
+
+// Tokenizes text on whitespace and looks every word up in the table.
+// Whole-word matching only, so "durum" does not match "dur".
+inline CommandMatch match_command(std::string_view text) {
+    CommandMatch best;
+    int best_priority = INT32_MAX;
+
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n')) i++;
+        size_t start = i;
+        while (i < text.size() && text[i] != ' ' && text[i] != '\t' && text[i] != '\n') i++;
+        if (i == start) break;
+
+        const CommandEntry* entry = lookup_command(text.substr(start, i - start));
+        if (entry != nullptr && entry->priority < best_priority) {
+            best.command = entry->command;
+            best.span = text.substr(start, i - start);
+            best_priority = entry->priority;
+        }
+    }
+    return best;
+}
+
+// Grammar JSON for vosk_recognizer_new_grm built from the table, e.g.
+// ["dur", "bekle", ..., "[unk]"]
+inline std::string build_command_grammar() {
+    std::string grammar = "[";
+    for (size_t i = 0; i < kCommandCount; i++) {
+        grammar += "\"";
+        grammar += kCommandTable[i].word;
+        grammar += "\", ";
+    }
+    grammar += "\"[unk]\"]";
+    return grammar;
+}
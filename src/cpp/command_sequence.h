@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#include "motion_packet.h"
+
+// --- TIMED COMMAND SEQUENCES ---
+// A high-level command (e.g. "walk forward") is a short list of steps with
+// delays between them. Sequences are executed by the control tick instead of
+// sleeping on the receive thread, and a newly submitted sequence replaces
+// whatever is still pending, so "stop" takes effect on the next tick.
+struct SequenceStep {
+    enum Kind {
+        SendCommand,  // Send a simple command (code)
+        SetMotion,    // Update the velocity streamed by the control loop
+        SendVelocity  // Send one velocity packet right now
+    };
+
+    Kind kind;
+    uint32_t code = 0;
+    double velocity = 0.0;
+    bool moving = false;
+    int64_t delay_ns = 0; // Wait after this step before running the next one
+};
+
+struct CommandSequence {
+    static constexpr size_t kMaxSteps = 6;
+
+    SequenceStep steps[kMaxSteps];
+    size_t count = 0;
+
+    // Code is a template argument so its payload type is checked at compile time
+    template <uint32_t Code>
+    CommandSequence& send(int64_t delay_ns = 0) {
+        static_assert(is_simple_command<Code>(), "send<Code>() needs a simple command code");
+        SequenceStep& s = add(SequenceStep::SendCommand);
+        s.code = Code;
+        s.delay_ns = delay_ns;
+        return *this;
+    }
+
+    CommandSequence& motion(double velocity, bool moving) {
+        SequenceStep& s = add(SequenceStep::SetMotion);
+        s.velocity = velocity;
+        s.moving = moving;
+        return *this;
+    }
+
+    template <uint32_t Code>
+    CommandSequence& send_velocity(double velocity) {
+        static_assert(std::is_same<typename CommandTraits<Code>::Payload, double>::value,
+                      "send_velocity<Code>() needs a command code with a double payload");
+        SequenceStep& s = add(SequenceStep::SendVelocity);
+        s.code = Code;
+        s.velocity = velocity;
+        return *this;
+    }
+
+private:
+    SequenceStep& add(SequenceStep::Kind kind) {
+        // Sequences are built from fixed tables in code; overflowing is a
+        // programming error. Never drop or overwrite a step (that could turn a
+        // stop into something else): fail loudly, in release builds too.
+        if (count == kMaxSteps) {
+            std::fprintf(stderr, "CommandSequence: more than %zu steps\n", kMaxSteps);
+            std::abort();
+        }
+        steps[count] = SequenceStep{kind};
+        return steps[count++];
+    }
+};
+
+// Owned by the controller's event loop thread (submit and tick).
+class CommandSequencer {
+public:
+    // Replace the running and pending steps with seq
+    void submit(const CommandSequence& seq) {
+        submitted_ = seq;
+        has_submitted_ = true;
+    }
+
+    // Once per control tick: runs every step that is due at now_ns.
+    // exec is called as exec(const SequenceStep&).
+    template <typename Exec>
+    void tick(int64_t now_ns, Exec&& exec) {
+        if (has_submitted_) {
+            active_ = submitted_;
+            has_submitted_ = false;
+            next_step_ = 0;
+            next_due_ns_ = now_ns; // Preempt: start immediately
+        }
+
+        while (next_step_ < active_.count && now_ns >= next_due_ns_) {
+            const SequenceStep& step = active_.steps[next_step_++];
+            exec(step);
+            // From the step's due time, not this tick: the control period
+            // would otherwise be added to every delay
+            next_due_ns_ += step.delay_ns;
+        }
+    }
+
+    bool idle() const { return next_step_ >= active_.count; }
+
+private:
+    CommandSequence submitted_;
+    bool has_submitted_ = false;
+
+    CommandSequence active_;
+    size_t next_step_ = 0;
+    int64_t next_due_ns_ = 0;
+};
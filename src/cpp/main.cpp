@@ -2,6 +2,11 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -9,12 +14,38 @@
 // Vosk and PortAudio header files
 #include <vosk_api.h>
 #include "../../include/portaudio.h"
+#include "audio_capture.h"
+#include "command_matcher.h"
+#include "chunk_scheduler.h"
+#include "recognition_pipeline.h"
+#include "speaker_verify.h"
+#include "model_prefetch.h"
+#include "command_gate.h"
 
 #define SAMPLE_RATE 16000
-#define FRAMES_PER_BUFFER 4000
+#define FRAMES_PER_BUFFER 4000       // Default decoder chunk (250 ms)
+#define CAPTURE_PERIOD_FRAMES 320    // Hardware period delivered to the ring (20 ms)
+#define MIN_CHUNK_FRAMES 320         // Adaptive chunking lower bound (20 ms)
 #define UDP_IP "127.0.0.1"
 #define UDP_PORT 5001
 #define MODEL_PATH "../../model"
+#define RING_SECONDS 4            // Capture ring size; absorbs decoder stalls up to this long
+#define DECODER_IDLE_SLEEP_MS 5   // Decoder poll interval while the ring is short of a chunk
+#define SPK_MODEL_PATH "../../model-spk"              // Vosk speaker (x-vector) model
+#define OWNER_XVECTOR_FILE "../../owner_xvector.txt" // Enrolled owner x-vector
+#define SPEAKER_THRESHOLD 0.5f                        // Minimum cosine similarity to the owner
+
+std::atomic<bool> running(true);
+std::atomic<bool> toggle_mode_requested(false);
+
+void handle_signal(int) {
+    running = false;
+}
+
+// SIGUSR1 switches between full vocabulary and command grammar at runtime
+void handle_toggle_signal(int) {
+    toggle_mode_requested = true;
+}
 
 // UDP Command Sending Function
 void send_udp_command(int sock, struct sockaddr_in& dest_addr, char command) {
@@ -22,40 +53,142 @@ void send_udp_command(int sock, struct sockaddr_in& dest_addr, char command) {
     std::cout << "Sent to C++: " << command << std::endl;
 }
 
-// Simple command analysis function
-// Searches within string without JSON library (Faster and simpler)
-void process_result(const char* json_result, int sock, struct sockaddr_in& dest_addr) {
-    std::string text(json_result);
-    
-    // Vosk may return empty result, check it
-    if (text.empty()) return;
-
-    std::cout << "Detected: " << text << std::endl;
+// --- SPEAKER VERIFICATION ---
+// Final results carry an x-vector when a speaker model is attached to the
+// recognizer; it is read in the same parse as the command and compared with
+// the enrolled owner.
+struct SpeakerAuth {
+    bool verify = false;    // Only the owner's commands are sent
+    int enroll_target = 0;  // > 0: enrollment mode, utterances still to collect
+    SpeakerVerifier verifier;
+    SpeakerEnrollment enrollment;
+    SpeakerEvidence result; // Reused for every final result (keeps the spk buffer)
+};
 
-    if (text.find("kalk") != std::string::npos || text.find("ayağa") != std::string::npos) {
-        send_udp_command(sock, dest_addr, 'K');
-    }
-    else if (text.find("otur") != std::string::npos) {
-        send_udp_command(sock, dest_addr, 'O');
+// Enrollment: collects x-vectors, saves the averaged owner vector when done
+void enroll_result(const std::vector<float>& spk, SpeakerAuth& auth) {
+    if (spk.empty()) {
+        std::cout << "(No speaker vector, speak a little longer)" << std::endl;
+        return;
     }
-    else if (text.find("ileri") != std::string::npos || text.find("git") != std::string::npos) {
-        // Distinguish forward and backward
-        if (text.find("geri") == std::string::npos) { // If it doesn't contain "geri", it's forward
-             send_udp_command(sock, dest_addr, 'I');
+    auth.enrollment.add(spk);
+    std::cout << "Enrollment: " << auth.enrollment.utterances << "/" << auth.enroll_target << std::endl;
+
+    if (auth.enrollment.utterances >= auth.enroll_target) {
+        if (save_speaker_vector(OWNER_XVECTOR_FILE, auth.enrollment.result())) {
+            std::cout << "Owner x-vector saved to '" << OWNER_XVECTOR_FILE << "'" << std::endl;
+        } else {
+            std::cerr << "ERROR: Could not write '" << OWNER_XVECTOR_FILE << "'" << std::endl;
         }
+        running = false;
     }
-    else if (text.find("geri") != std::string::npos) {
-        send_udp_command(sock, dest_addr, 'G');
+}
+
+// Handles a final result. already_sent is the command fired early from
+// partial results of the same utterance (0 if none); it is not sent twice.
+// With a gate, commands below their confidence threshold wait for a repeat.
+void process_result(const char* json_result, int sock, struct sockaddr_in& dest_addr, char already_sent,
+                    SpeakerAuth& auth, ConfirmationGate* gate) {
+    // One pass over the result: text plus the command word, its confidence,
+    // the n-best margin and the speaker vector when the recognizer reports them
+    SpeakerEvidence& result = auth.result;
+    result.parse(json_result);
+
+    // Vosk may return empty result, check it
+    if (result.text.empty()) return;
+
+    std::cout << "Detected: " << result.text << std::endl;
+
+    if (auth.enroll_target > 0) {
+        enroll_result(result.spk, auth);
+        return;
     }
-    else if (text.find("takip") != std::string::npos || text.find("başla") != std::string::npos) {
-        send_udp_command(sock, dest_addr, '1');
+
+    // Speaker verification runs before the gate: an unauthorized voice must
+    // neither hold nor confirm a command. Stop ('0') is exempt, from any voice,
+    // just as it may fire early from partials that carry no x-vector
+    CommandVerdict verdict = command_verdict(result, already_sent, gate, monotonic_ns(), [&](const CommandEvidence& e) {
+        if (!auth.verify || e.command() == '0') return true;
+        float score = auth.verifier.score(result.spk);
+        std::cout << "Identity Score: " << score << std::endl;
+        return score >= auth.verifier.threshold;
+    });
+    char command = result.command();
+
+    switch (verdict) {
+        case CommandVerdict::None:
+            return;
+        case CommandVerdict::AlreadySent:
+            std::cout << "(Already sent early: " << command << ")" << std::endl;
+            return;
+        case CommandVerdict::Denied:
+            std::cout << "DENIED: Unauthorized voice." << std::endl;
+            return;
+        case CommandVerdict::Confirm:
+        case CommandVerdict::Send:
+            break;
     }
-    else if (text.find("dur") != std::string::npos || text.find("bekle") != std::string::npos) {
-        send_udp_command(sock, dest_addr, '0');
+
+    std::cout << "Matched: '" << result.pick.word.word << "'";
+    if (result.pick.word.conf >= 0) std::cout << " (conf " << result.pick.word.conf << ")";
+    if (!std::isinf(result.margin)) std::cout << " (n-best margin " << result.margin << ")";
+    std::cout << std::endl;
+
+    if (verdict == CommandVerdict::Confirm) {
+        std::cout << "CONFIRM: not sure about '" << result.pick.word.word << "', say it again to send "
+                  << command << std::endl;
+        return;
     }
+    send_udp_command(sock, dest_addr, command);
 }
 
-int main() {
+int main(int argc, char** argv) {
+    RecognizerMode mode = RecognizerMode::FullVocabulary;
+    bool early_fire = false;
+    bool adaptive_chunk = false;
+    bool latency_log = false;
+    bool use_vad = false;
+    bool prefetch_model = false;
+    bool confidence_gate = false;
+    int nbest = 0; // Alternatives requested from Vosk, 0 = off
+    size_t chunk_frames = FRAMES_PER_BUFFER;
+    SpeakerAuth speaker;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--grammar") == 0) {
+            mode = RecognizerMode::CommandGrammar;
+        } else if (strcmp(argv[i], "--early-fire") == 0) {
+            early_fire = true;
+        } else if (strcmp(argv[i], "--adaptive-chunk") == 0) {
+            adaptive_chunk = true;
+        } else if (strcmp(argv[i], "--latency-log") == 0) {
+            latency_log = true;
+        } else if (strcmp(argv[i], "--vad") == 0) {
+            use_vad = true;
+        } else if (strcmp(argv[i], "--prefetch") == 0) {
+            prefetch_model = true;
+        } else if (strcmp(argv[i], "--confidence") == 0) {
+            confidence_gate = true;
+        } else if (strcmp(argv[i], "--nbest") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 1) {
+            nbest = atoi(argv[++i]);
+            confidence_gate = true;
+        } else if (strcmp(argv[i], "--speaker") == 0) {
+            speaker.verify = true;
+        } else if (strcmp(argv[i], "--enroll-speaker") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            speaker.enroll_target = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk-ms") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            chunk_frames = (size_t)atoi(argv[++i]) * SAMPLE_RATE / 1000;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--grammar] [--early-fire] [--chunk-ms N] [--adaptive-chunk] [--latency-log] [--vad]"
+                      << " [--speaker | --enroll-speaker N] [--prefetch] [--confidence] [--nbest N]" << std::endl;
+            std::cerr << "  --chunk-ms N       Decoder chunk in ms (adaptive mode: upper bound), default "
+                      << FRAMES_PER_BUFFER * 1000 / SAMPLE_RATE << std::endl;
+            std::cerr << "  --confidence       Send only when the command word's conf clears its threshold" << std::endl;
+            std::cerr << "  --nbest N          Gate on the margin over N-best alternatives (N >= 2)" << std::endl;
+            return -1;
+        }
+    }
+
     // --- 1. UDP SOCKET SETUP ---
     int sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock < 0) {
@@ -70,13 +203,57 @@ int main() {
     dest_addr.sin_addr.s_addr = inet_addr(UDP_IP);
 
     // --- 2. VOSK MODEL LOADING ---
+    bool use_spk_model = speaker.verify || speaker.enroll_target > 0;
+    ModelPrefetch prefetch;
+    if (prefetch_model) {
+        // Runs while vosk_model_new() parses the files that are already in memory
+        size_t files = prefetch.start(MODEL_PATH);
+        if (use_spk_model) files += prefetch.start(SPK_MODEL_PATH);
+        std::cout << "Prefetching " << files << " model files..." << std::endl;
+    }
+
     std::cout << "Loading model (model directory)..." << std::endl;
+    auto load_start = std::chrono::steady_clock::now();
     VoskModel *model = vosk_model_new(MODEL_PATH);
     if (model == nullptr) {
         std::cerr << "ERROR: '" << MODEL_PATH << "' directory not found or model is invalid!" << std::endl;
         return -1;
     }
-    VoskRecognizer *recognizer = vosk_recognizer_new(model, SAMPLE_RATE);
+    std::cout << "Model loaded in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - load_start).count() << " ms" << std::endl;
+    VoskRecognizer *recognizer = create_recognizer(model, mode, SAMPLE_RATE);
+    if (recognizer == nullptr) {
+        std::cerr << "ERROR: Recognizer could not be created (" << mode_name(mode) << ")!" << std::endl;
+        return -1;
+    }
+    if (confidence_gate) enable_command_evidence(recognizer, nbest);
+
+    // Speaker model: x-vectors come out of the same decode pass as the text
+    VoskSpkModel *spk_model = nullptr;
+    if (use_spk_model) {
+        std::cout << "Loading speaker model (" << SPK_MODEL_PATH << ")..." << std::endl;
+        spk_model = vosk_spk_model_new(SPK_MODEL_PATH);
+        if (spk_model == nullptr) {
+            std::cerr << "ERROR: '" << SPK_MODEL_PATH << "' speaker model not found or invalid!" << std::endl;
+            return -1;
+        }
+        vosk_recognizer_set_spk_model(recognizer, spk_model);
+    }
+    if (prefetch_model) {
+        prefetch.wait();
+        const PrefetchStats& ps = prefetch.stats();
+        std::cout << "Prefetch: " << ps.files << " files, " << ps.bytes / (1024 * 1024) << " MB, slowest file "
+                  << ps.slowest_us / 1000 << " ms" << std::endl;
+    }
+    if (speaker.verify) {
+        if (!load_speaker_vector(OWNER_XVECTOR_FILE, speaker.verifier.owner)) {
+            std::cerr << "ERROR: '" << OWNER_XVECTOR_FILE << "' not found." << std::endl;
+            std::cerr << "Please run with --enroll-speaker N first to create the owner x-vector." << std::endl;
+            return -1;
+        }
+        speaker.verifier.threshold = SPEAKER_THRESHOLD;
+        speaker.result.spk.reserve(speaker.verifier.owner.size());
+    }
 
     // --- 3. MICROPHONE (PORTAUDIO) SETTINGS ---
     PaError err = Pa_Initialize();
@@ -85,56 +262,151 @@ int main() {
         return -1;
     }
 
-    PaStream *stream;
-    err = Pa_OpenDefaultStream(&stream,
-                               1,          // Input channel (Mono)
-                               0,          // Output channel (None)
-                               paInt16,    // Format (16 bit integer)
-                               SAMPLE_RATE,
-                               FRAMES_PER_BUFFER,
-                               NULL,       // No callback, we'll do blocking read
-                               NULL);
+    // Callback mode: PortAudio thread only fills the ring, decoding happens elsewhere
+    AudioCapture capture(RING_SECONDS * SAMPLE_RATE);
+    err = capture_open(capture, SAMPLE_RATE, CAPTURE_PERIOD_FRAMES);
 
     if (err != paNoError) {
         std::cerr << "Stream opening error: " << Pa_GetErrorText(err) << std::endl;
         return -1;
     }
 
-    err = Pa_StartStream(stream);
+    err = Pa_StartStream(capture.stream);
     if (err != paNoError) {
         std::cerr << "Stream starting error: " << Pa_GetErrorText(err) << std::endl;
         return -1;
     }
 
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+    std::signal(SIGUSR1, handle_toggle_signal);
+
     std::cout << "\nOFFLINE MODE READY! (C++ Version)" << std::endl;
-    std::cout << "Commands: Kalk, Otur, İleri, Geri, Takip, Dur" << std::endl;
+    std::cout << "Commands: Kalk, Otur, İleri, Geri, Takip, Dur, Selam" << std::endl;
+    std::cout << "Recognizer mode: " << mode_name(mode) << " (send SIGUSR1 to switch)" << std::endl;
+    if (early_fire) {
+        std::cout << "Early firing: after " << EARLY_FIRE_STABLE_PARTIALS << " stable partial results" << std::endl;
+    }
+    if (speaker.verify) {
+        std::cout << "Speaker verification: on (threshold " << SPEAKER_THRESHOLD << ")" << std::endl;
+    }
+    if (confidence_gate) {
+        std::cout << "Confidence gate: " << (nbest > 0 ? "n-best margin over " + std::to_string(nbest) + " alternatives"
+                                                       : std::string("word confidence"))
+                  << ", low-confidence commands must be repeated (stop is never held)" << std::endl;
+    }
+    if (speaker.enroll_target > 0) {
+        std::cout << "ENROLLMENT: say " << speaker.enroll_target << " sentences, commands are not sent" << std::endl;
+    }
 
-    // --- 4. MAIN LOOP ---
-    int16_t buffer[FRAMES_PER_BUFFER];
-    
-    while (true) {
-        // Read from microphone
-        err = Pa_ReadStream(stream, buffer, FRAMES_PER_BUFFER);
-        if (err != paNoError && err != paInputOverflowed) {
-            std::cerr << "Read error!" << std::endl;
-            break; 
-        }
+    ChunkScheduler chunks(CAPTURE_PERIOD_FRAMES, MIN_CHUNK_FRAMES, chunk_frames, adaptive_chunk);
+    if (adaptive_chunk) {
+        std::cout << "Chunking: adaptive " << MIN_CHUNK_FRAMES * 1000 / SAMPLE_RATE << "-"
+                  << chunks.max_chunk() * 1000 / SAMPLE_RATE << " ms" << std::endl;
+    } else {
+        std::cout << "Chunking: fixed " << chunks.max_chunk() * 1000 / SAMPLE_RATE << " ms" << std::endl;
+    }
 
-        // Send to Vosk (C API requires int16 data as char*)
-        if (vosk_recognizer_accept_waveform(recognizer, (const char *)buffer, FRAMES_PER_BUFFER * 2)) {
-            // Get result when complete sentence is finished
-            const char *result = vosk_recognizer_result(recognizer);
-            process_result(result, sock, dest_addr);
-        } else {
-            // Partial result can be obtained if sentence is not finished, but we wait for complete result.
+    // Hardware input latency is added to every mic-to-decoder measurement
+    const PaStreamInfo* stream_info = Pa_GetStreamInfo(capture.stream);
+    double input_latency = stream_info ? stream_info->inputLatency : 0.0;
+    LatencyStats latency;
+
+    // Optional voice activity gate: silence never reaches the decoder
+    PipelineConfig pipeline_config;
+    pipeline_config.early_fire = early_fire && speaker.enroll_target == 0;
+    // Partials carry no conf or x-vector; stop is exempt from both checks
+    pipeline_config.early_stop_only = speaker.verify || confidence_gate;
+    pipeline_config.use_vad = use_vad;
+    RecognitionPipeline pipeline(recognizer, pipeline_config, chunks.max_chunk());
+    ConfirmationGate gate; // Used by the decoder thread only
+    if (use_vad) {
+        std::cout << "VAD gate: on (RMS >= " << pipeline_config.vad.rms_threshold << ")" << std::endl;
+    }
+
+    // --- 4. DECODER THREAD ---
+    // Drains the ring so Kaldi decode time never blocks the microphone
+    std::thread decoder([&]() {
+        std::vector<int16_t> buffer(chunks.max_chunk());
+
+        while (running) {
+            if (toggle_mode_requested.exchange(false)) {
+                mode = mode == RecognizerMode::CommandGrammar ? RecognizerMode::FullVocabulary
+                                                              : RecognizerMode::CommandGrammar;
+                pipeline.set_mode(mode);
+            }
+
+            size_t frames = chunks.next_chunk();
+            size_t available = capture.ring.available();
+            if (available < frames) {
+                // Sleep about one capture period, never longer than the idle poll interval
+                std::this_thread::sleep_for(std::chrono::milliseconds(
+                    std::min(DECODER_IDLE_SLEEP_MS, CAPTURE_PERIOD_FRAMES * 1000 / SAMPLE_RATE)));
+                continue;
+            }
+            int64_t read_ns = monotonic_ns();
+            int64_t newest_ns = capture.stats.last_callback_ns.load(std::memory_order_relaxed);
+            capture.ring.read(buffer.data(), frames);
+
+            // Age of the newest sample in this chunk when it was taken from the ring:
+            // time since the last callback plus whatever is still queued behind it
+            double queued = (double)(available - frames) / SAMPLE_RATE;
+            double age = (read_ns - newest_ns) / 1e9 + queued;
+
+            DecodeEvent event = pipeline.decode(buffer.data(), frames);
+
+            double decode = (monotonic_ns() - read_ns) / 1e9;
+            double mic_to_decoder = input_latency + age + decode;
+            latency.add(mic_to_decoder);
+            chunks.on_decoded(frames, decode, SAMPLE_RATE, capture.ring.available());
+            if (latency_log) {
+                std::cout << "[latency] chunk=" << frames * 1000 / SAMPLE_RATE << "ms"
+                          << " queued=" << (int)(queued * 1000) << "ms"
+                          << " decode=" << (int)(decode * 1000) << "ms"
+                          << " mic_to_decoder=" << (int)(mic_to_decoder * 1000) << "ms" << std::endl;
+            }
+
+            if (event.kind == DecodeEvent::Result) {
+                process_result(event.json, sock, dest_addr, event.already_sent, speaker,
+                               confidence_gate ? &gate : nullptr);
+            } else if (event.kind == DecodeEvent::EarlyFire) {
+                std::cout << "Early fire (partial): " << event.command << std::endl;
+                send_udp_command(sock, dest_addr, event.command);
+            }
         }
+    });
+
+    decoder.join();
+
+    std::cout << "\nCapture stats: callbacks=" << capture.stats.callbacks
+              << " overruns=" << capture.stats.overruns
+              << " dropped_samples=" << capture.stats.dropped_samples
+              << " input_overflows=" << capture.stats.input_overflows
+              << " ring_high_water=" << capture.stats.high_water << "/" << capture.ring.capacity()
+              << std::endl;
+    std::cout << "Latency (mic to decoded, newest sample): chunks=" << latency.chunks
+              << " mean=" << (int)(latency.mean() * 1000) << "ms"
+              << " max=" << (int)(latency.max * 1000) << "ms"
+              << " final_chunk=" << chunks.next_chunk() * 1000 / SAMPLE_RATE << "ms" << std::endl;
+    if (use_vad) {
+        uint64_t gated = pipeline.vad_stats().frames_gated;
+        uint64_t decoded = pipeline.vad_stats().frames_decoded;
+        std::cout << "VAD stats: frames_gated=" << gated << " frames_decoded=" << decoded
+                  << " (" << (gated + decoded ? 100 * gated / (gated + decoded) : 0) << "% not decoded)"
+                  << std::endl;
+    }
+    if (confidence_gate) {
+        std::cout << "Confidence gate: sent_confident=" << gate.stats().confident
+                  << " sent_after_repeat=" << gate.stats().confirmed
+                  << " held=" << gate.stats().held << std::endl;
     }
 
     // --- CLEANUP ---
-    Pa_StopStream(stream);
-    Pa_CloseStream(stream);
+    Pa_StopStream(capture.stream);
+    Pa_CloseStream(capture.stream);
     Pa_Terminate();
     vosk_recognizer_free(recognizer);
+    if (spk_model != nullptr) vosk_spk_model_free(spk_model);
     vosk_model_free(model);
     close(sock);
 
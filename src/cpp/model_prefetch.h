@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- MODEL FILE PREFETCH ---
+// vosk_model_new() parses final.mdl, HCLr.fst, Gr.fst and the i-vector
+// files one after another with ordinary reads. Prefetching maps every model
+// file read-only and faults it into the page cache from one thread per file,
+// started just before vosk_model_new(): storage reads run in parallel and
+// overlap with Kaldi parsing the files that are already in memory.
+//
+// The page cache is shared, so a second front-end (Python or C++) loading
+// the same model reads it from RAM. Kaldi still copies the model into its
+// own heap; this saves I/O time, not per-process model memory.
+constexpr size_t kMinPrefetchBytes = 64 * 1024; // Small config files aren't worth a thread
+
+struct PrefetchStats {
+    std::atomic<size_t> files{0};
+    std::atomic<size_t> bytes{0};
+    std::atomic<int64_t> slowest_us{0}; // Longest single-file prefetch
+};
+
+class ModelPrefetch {
+public:
+    ~ModelPrefetch() { wait(); }
+
+    // Starts one prefetch thread per model file under dir (may be called for
+    // several model directories). Returns the number of files queued.
+    size_t start(const std::string& dir) {
+        namespace fs = std::filesystem;
+        if (threads_.empty()) start_ = std::chrono::steady_clock::now();
+        size_t queued = threads_.size();
+
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec) || it->file_size(ec) < kMinPrefetchBytes) continue;
+            threads_.emplace_back(&ModelPrefetch::prefetch_file, this, it->path().string());
+        }
+        if (ec) std::cerr << "Prefetch: cannot scan '" << dir << "': " << ec.message() << std::endl;
+        return threads_.size() - queued;
+    }
+
+    // Joins the prefetch threads (the model is loaded by then, or still
+    // loading and reading from the page cache). Returns the elapsed time.
+    int64_t wait() {
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+    }
+
+    const PrefetchStats& stats() const { return stats_; }
+
+private:
+    void prefetch_file(std::string path) {
+        auto t0 = std::chrono::steady_clock::now();
+
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return;
+        }
+        size_t size = (size_t)st.st_size;
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps the file referenced
+        if (addr == MAP_FAILED) {
+            std::cerr << "Prefetch: mmap '" << path << "' failed: " << strerror(errno) << std::endl;
+            return;
+        }
+
+        // Start readahead of the whole file, then touch every page so the
+        // thread returns only once the file is resident
+        madvise(addr, size, MADV_WILLNEED);
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const volatile unsigned char* p = static_cast<const unsigned char*>(addr);
+        unsigned char sink = 0;
+        for (size_t off = 0; off < size; off += page) sink ^= p[off];
+        (void)sink;
+        munmap(addr, size);
+
+        stats_.files.fetch_add(1, std::memory_order_relaxed);
+        stats_.bytes.fetch_add(size, std::memory_order_relaxed);
+        int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+        int64_t prev = stats_.slowest_us.load(std::memory_order_relaxed);
+        while (us > prev && !stats_.slowest_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+    }
+
+    std::vector<std::thread> threads_;
+    std::chrono::steady_clock::time_point start_;
+    PrefetchStats stats_;
+};
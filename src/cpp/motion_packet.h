@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// --- PROTOCOL STRUCTURES ---
+struct CommandHead {
+    uint32_t code;
+    uint32_t parameters_size;
+    uint32_t type;
+};
+
+// Largest payload the protocol allows (Command.data in the documentation)
+const uint32_t kDataSize = 256;
+
+// --- COMMAND CODES FROM DOCUMENTATION ---
+const uint32_t CMD_HEARTBEAT     = 0x21040001; // [cite: 1876]
+const uint32_t CMD_STAND_SIT     = 0x21010202; // [cite: 1917] Stand/Sit Toggle
+const uint32_t CMD_MOVE_MODE     = 0x21010D06; //  Move Mode (Walking Mode)
+const uint32_t CMD_NAV_MODE      = 0x21010C03; //  Navigation Mode (Listen to PC Mode)
+const uint32_t CMD_VEL_X         = 0x0140;     // [cite: 1996] X Velocity (Forward/Backward)
+const uint32_t CMD_HELLO         = 0x21010507; // [cite: 1948] Hello/Greeting
+
+// --- PAYLOAD TYPE PER COMMAND CODE ---
+// Simple commands (type 0) carry their value in parameters_size and have no
+// payload; complex commands (type 1) carry a typed payload after the head.
+// Using a code without an entry here is a compile error.
+template <uint32_t Code> struct CommandTraits;
+
+struct SimpleCommand { using Payload = void; };
+template <> struct CommandTraits<CMD_HEARTBEAT> : SimpleCommand {};
+template <> struct CommandTraits<CMD_STAND_SIT> : SimpleCommand {};
+template <> struct CommandTraits<CMD_MOVE_MODE> : SimpleCommand {};
+template <> struct CommandTraits<CMD_NAV_MODE>  : SimpleCommand {};
+template <> struct CommandTraits<CMD_HELLO>     : SimpleCommand {};
+template <> struct CommandTraits<CMD_VEL_X>     { using Payload = double; };
+
+template <uint32_t Code>
+constexpr bool is_simple_command() {
+    return std::is_void<typename CommandTraits<Code>::Payload>::value;
+}
+
+// --- PREALLOCATED PACKET ---
+// Head and payload serialized back to back into a fixed buffer that is
+// reused across sends: no per-send zeroing of the full 1 KB Command.
+class MotionPacket {
+public:
+    static constexpr size_t kMaxPayload = 16; // Largest payload any CommandTraits uses
+
+    template <uint32_t Code>
+    void set_simple(uint32_t value = 0) {
+        static_assert(is_simple_command<Code>(), "Command code takes a payload, use set<Code>(payload)");
+        set_simple_runtime(Code, value);
+    }
+
+    template <uint32_t Code, typename T>
+    void set(const T& payload) {
+        using Payload = typename CommandTraits<Code>::Payload;
+        static_assert(!std::is_void<Payload>::value, "Simple command code, use set_simple<Code>()");
+        static_assert(std::is_same<T, Payload>::value, "Wrong payload type for command code");
+        set_payload_runtime(Code, &payload, sizeof(Payload));
+    }
+
+    // Overwrite the payload of an already built complex packet (e.g. new velocity)
+    template <uint32_t Code, typename T>
+    void update(const T& payload) {
+        static_assert(std::is_same<T, typename CommandTraits<Code>::Payload>::value,
+                      "Wrong payload type for command code");
+        memcpy(bytes_ + sizeof(CommandHead), &payload, sizeof(T));
+    }
+
+    // For codes only known at runtime (e.g. stored in a command sequence);
+    // the sequence builder has already checked them at compile time
+    void set_simple_runtime(uint32_t code, uint32_t value) {
+        CommandHead head = {code, value, 0};
+        memcpy(bytes_, &head, sizeof(head));
+        size_ = sizeof(head);
+    }
+
+    void set_payload_runtime(uint32_t code, const void* payload, uint32_t payload_size) {
+        if (payload_size > kMaxPayload) payload_size = kMaxPayload;
+        CommandHead head = {code, payload_size, 1};
+        memcpy(bytes_, &head, sizeof(head));
+        memcpy(bytes_ + sizeof(head), payload, payload_size);
+        size_ = sizeof(head) + payload_size;
+    }
+
+    const void* data() const { return bytes_; }
+    size_t size() const { return size_; }
+
+private:
+    alignas(8) unsigned char bytes_[sizeof(CommandHead) + kMaxPayload] = {};
+    size_t size_ = 0;
+};
+
+static_assert(MotionPacket::kMaxPayload <= kDataSize * sizeof(uint32_t), "Payload exceeds protocol limit");
+
+// --- BATCHED SEND ---
+// Sends up to kMaxBatch packets on a connected UDP socket with one
+// sendmmsg() call. Returns the number of packets sent, or -1.
+constexpr size_t kMaxBatch = 4;
+
+inline int send_packets(int fd, const MotionPacket* const* packets, size_t count) {
+    if (count > kMaxBatch) count = kMaxBatch;
+
+    struct iovec iov[kMaxBatch];
+    struct mmsghdr msgs[kMaxBatch];
+    memset(msgs, 0, sizeof(msgs[0]) * count);
+    for (size_t i = 0; i < count; i++) {
+        iov[i].iov_base = const_cast<void*>(packets[i]->data());
+        iov[i].iov_len = packets[i]->size();
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return sendmmsg(fd, msgs, (unsigned int)count, 0);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// --- TIMESPEC HELPERS (CLOCK_MONOTONIC) ---
+inline int64_t timespec_to_ns(const struct timespec& ts) {
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+inline struct timespec ns_to_timespec(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    return ts;
+}
+
+inline int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_to_ns(ts);
+}
+
+// --- TICK STATISTICS ---
+// Wake-up jitter histogram and deadline-miss counters for a periodic loop.
+// Written by the loop thread, read by anyone.
+struct TickStats {
+    // Upper bounds (microseconds) of the jitter histogram buckets; the last
+    // bucket counts everything above the final bound.
+    static constexpr int kBuckets = 8;
+    static constexpr int64_t kBucketUs[kBuckets - 1] = {50, 100, 250, 500, 1000, 2000, 5000};
+
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> deadline_misses{0}; // Woke up later than the deadline
+    std::atomic<uint64_t> skipped_ticks{0};   // Whole periods lost (not sent at all)
+    std::atomic<int64_t> max_jitter_us{0};
+    std::atomic<uint64_t> histogram[kBuckets] = {};
+
+    void record(int64_t lateness_ns, int64_t deadline_ns) {
+        ticks.fetch_add(1, std::memory_order_relaxed);
+        int64_t us = lateness_ns > 0 ? lateness_ns / 1000 : 0;
+
+        int bucket = 0;
+        while (bucket < kBuckets - 1 && us >= kBucketUs[bucket]) bucket++;
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        if (us > max_jitter_us.load(std::memory_order_relaxed)) {
+            max_jitter_us.store(us, std::memory_order_relaxed);
+        }
+        if (lateness_ns > deadline_ns) {
+            deadline_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void print(std::ostream& out) const {
+        out << "Tick stats: ticks=" << ticks << " deadline_misses=" << deadline_misses
+            << " skipped=" << skipped_ticks << " max_jitter=" << max_jitter_us << "us" << std::endl;
+        out << "Jitter histogram:";
+        for (int i = 0; i < kBuckets; i++) {
+            if (i < kBuckets - 1) {
+                out << " <" << kBucketUs[i] << "us:" << histogram[i];
+            } else {
+                out << " >=" << kBucketUs[kBuckets - 2] << "us:" << histogram[i];
+            }
+        }
+        out << std::endl;
+    }
+};
+
+// --- ABSOLUTE-DEADLINE PERIODIC TIMER ---
+// timerfd armed at absolute times (start + k * period), so loop cost and
+// wake-up jitter never accumulate into drift. The fd plugs into epoll.
+// If whole periods are lost they collapse into one tick instead of a burst.
+class PeriodicTimer {
+public:
+    PeriodicTimer(int64_t period_ns, int64_t deadline_ns, TickStats& stats)
+        : period_ns_(period_ns), deadline_ns_(deadline_ns), stats_(stats) {
+        fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd_ < 0) return;
+
+        first_ns_ = now_ns() + period_ns;
+        struct itimerspec spec;
+        spec.it_value = ns_to_timespec(first_ns_);
+        spec.it_interval = ns_to_timespec(period_ns);
+        if (timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    ~PeriodicTimer() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    PeriodicTimer(const PeriodicTimer&) = delete;
+    PeriodicTimer& operator=(const PeriodicTimer&) = delete;
+
+    int fd() const { return fd_; }
+
+    // Call when fd is readable. Returns true if a tick is due.
+    bool on_readable() {
+        uint64_t expirations = 0;
+        if (read(fd_, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations) || expirations == 0) {
+            return false;
+        }
+        expirations_ += expirations;
+
+        // Lateness relative to the most recent scheduled expiration
+        int64_t scheduled = first_ns_ + (int64_t)(expirations_ - 1) * period_ns_;
+        stats_.record(now_ns() - scheduled, deadline_ns_);
+        if (expirations > 1) {
+            stats_.skipped_ticks.fetch_add(expirations - 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+private:
+    int64_t period_ns_;
+    int64_t deadline_ns_;
+    TickStats& stats_;
+    int fd_ = -1;
+    int64_t first_ns_ = 0;
+    uint64_t expirations_ = 0;
+};
+
+// --- THREAD SCHEDULING ---
+// priority > 0: SCHED_FIFO at that priority (needs CAP_SYS_NICE or root).
+// cpu >= 0: pin the thread to that CPU. Failures are reported, not fatal.
+inline void configure_realtime_thread(pthread_t thread, int priority, int cpu) {
+    if (priority > 0) {
+        // Page faults in the loop would defeat the real-time priority
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            std::cerr << "mlockall failed: " << strerror(errno) << std::endl;
+        }
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int rc = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (rc != 0) {
+            std::cerr << "SCHED_FIFO priority " << priority << " failed: " << strerror(rc) << std::endl;
+        }
+    }
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int rc = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (rc != 0) {
+            std::cerr << "Pinning to CPU " << cpu << " failed: " << strerror(rc) << std::endl;
+        }
+    }
+}
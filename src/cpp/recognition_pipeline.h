@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include <vosk_api.h>
+#include "command_matcher.h"
+#include "vad.h"
+
+// Grammar mode decodes against the command vocabulary (kCommandTable in
+// command_matcher.h) plus "[unk]". The model is a lookahead model
+// (HCLr.fst + Gr.fst), so this tiny grammar replaces the full n-gram.
+#define FULL_GRAMMAR "[]" // Vosk: "[]" switches back to the default model graph
+#define EARLY_FIRE_STABLE_PARTIALS 2 // Partials that must agree before firing early
+
+enum class RecognizerMode { FullVocabulary, CommandGrammar };
+
+inline const char* mode_name(RecognizerMode mode) {
+    return mode == RecognizerMode::CommandGrammar ? "command grammar" : "full vocabulary";
+}
+
+inline VoskRecognizer* create_recognizer(VoskModel* model, RecognizerMode mode, float sample_rate) {
+    if (mode == RecognizerMode::CommandGrammar) {
+        return vosk_recognizer_new_grm(model, sample_rate, build_command_grammar().c_str());
+    }
+    return vosk_recognizer_new(model, sample_rate);
+}
+
+// Vosk only accepts a new graph between utterances, so drop the pending one first
+inline void set_recognizer_mode(VoskRecognizer* recognizer, RecognizerMode mode) {
+    vosk_recognizer_reset(recognizer);
+    vosk_recognizer_set_grm(recognizer, mode == RecognizerMode::CommandGrammar ? build_command_grammar().c_str()
+                                                                               : FULL_GRAMMAR);
+    std::cout << "Recognizer mode: " << mode_name(mode) << std::endl;
+}
+
+// Results for the confidence gate (command_gate.h): word lists with per-word
+// conf, and with nbest > 0 that many alternatives carrying n-best scores
+inline void enable_command_evidence(VoskRecognizer* recognizer, int nbest) {
+    vosk_recognizer_set_words(recognizer, 1);
+    if (nbest > 0) vosk_recognizer_set_max_alternatives(recognizer, nbest);
+}
+
+// Command analysis for partial results: reads the "partial" (or "text")
+// field in place and matches whole words against the compiled table in
+// command_matcher.h. Final results go through CommandEvidence and
+// command_verdict (command_gate.h) instead.
+// Returns the robot command character, or 0 if no command was found
+inline char detect_command(const char* json_result, std::string_view key = "text") {
+    return match_command(json_string_field(json_result, key)).command;
+}
+
+// --- EARLY FIRING FROM PARTIAL RESULTS ---
+// A command is fired before end-of-utterance once the same command has been
+// detected in EARLY_FIRE_STABLE_PARTIALS consecutive partial results.
+struct EarlyFireState {
+    char candidate = 0;   // Command in the latest partial
+    int stable_count = 0; // Consecutive partials agreeing on candidate
+    char fired = 0;       // Command already sent for this utterance
+
+    // Returns the command to fire now, or 0
+    char update(char command) {
+        if (command == 0 || command != candidate) {
+            candidate = command;
+            stable_count = command ? 1 : 0;
+        } else {
+            stable_count++;
+        }
+        if (candidate != 0 && candidate != fired && stable_count >= EARLY_FIRE_STABLE_PARTIALS) {
+            fired = candidate;
+            return fired;
+        }
+        return 0;
+    }
+
+    void reset() {
+        candidate = 0;
+        stable_count = 0;
+        fired = 0;
+    }
+};
+
+// --- RECOGNITION PIPELINE ---
+// Everything between "a chunk of int16 audio" and "a result or an early
+// command": optional VAD gate, vosk_recognizer_accept_waveform, endpoint /
+// gate-close flushing and early firing. No capture and no sending, so the
+// live front-end (main.cpp) and the offline replay benchmark
+// (replay_bench.cpp) run exactly the same decode path.
+struct PipelineConfig {
+    bool early_fire = false;      // Act on stable partial results
+    bool early_stop_only = false; // Only stop may fire early (partials carry no speaker vector)
+    bool use_vad = false;
+    VadConfig vad;
+};
+
+struct DecodeEvent {
+    enum Kind { None, Result, EarlyFire };
+    Kind kind = None;
+    const char* json = nullptr; // Result: owned by the recognizer, valid until the next decode
+    char command = 0;           // EarlyFire: command to send now
+    char already_sent = 0;      // Result: command fired early in the same utterance
+};
+
+class RecognitionPipeline {
+public:
+    // The recognizer is borrowed, not freed
+    RecognitionPipeline(VoskRecognizer* recognizer, const PipelineConfig& config, size_t max_chunk)
+        : recognizer_(recognizer), config_(config), vad_(config.vad) {
+        vad_out_.reserve(max_chunk + config.vad.preroll_frames * config.vad.frame_size);
+    }
+
+    const PipelineConfig& config() const { return config_; }
+    const VadStats& vad_stats() const { return vad_.stats(); }
+
+    // Decodes one chunk; at most one event per chunk
+    DecodeEvent decode(const int16_t* samples, size_t frames) {
+        const int16_t* feed = samples;
+        size_t feed_frames = frames;
+        bool gate_closed = false;
+        if (config_.use_vad) {
+            vad_out_.clear();
+            gate_closed = vad_.process(samples, frames, vad_out_);
+            feed = vad_out_.data();
+            feed_frames = vad_out_.size();
+        }
+
+        // Send to Vosk (C API requires int16 data as char*)
+        int accepted = 0;
+        if (feed_frames > 0) {
+            accepted = vosk_recognizer_accept_waveform(recognizer_, (const char*)feed, (int)feed_frames * 2);
+            utterance_pending_ = true;
+        }
+
+        if (accepted > 0) {
+            // Get result when complete sentence is finished
+            return result(vosk_recognizer_result(recognizer_));
+        }
+        if (gate_closed && utterance_pending_) {
+            // Speech region ended before Vosk saw an endpoint: flush it now
+            return result(vosk_recognizer_final_result(recognizer_));
+        }
+        if (config_.early_fire && feed_frames > 0) {
+            // Sentence not finished yet: act on the partial result once it is stable
+            char partial = detect_command(vosk_recognizer_partial_result(recognizer_), "partial");
+            if (config_.early_stop_only && partial != '0') partial = 0;
+            DecodeEvent event;
+            event.command = early_.update(partial);
+            if (event.command != 0) event.kind = DecodeEvent::EarlyFire;
+            return event;
+        }
+        return DecodeEvent();
+    }
+
+    // End of input: final result of audio fed since the last result
+    DecodeEvent flush() {
+        if (!utterance_pending_) return DecodeEvent();
+        return result(vosk_recognizer_final_result(recognizer_));
+    }
+
+    // New audio source or new recognizer graph: drops all utterance state
+    void reset() {
+        vosk_recognizer_reset(recognizer_);
+        vad_.reset();
+        early_.reset();
+        utterance_pending_ = false;
+    }
+
+    void set_mode(RecognizerMode mode) {
+        set_recognizer_mode(recognizer_, mode);
+        early_.reset();
+    }
+
+private:
+    DecodeEvent result(const char* json) {
+        DecodeEvent event;
+        event.kind = DecodeEvent::Result;
+        event.json = json;
+        event.already_sent = early_.fired;
+        early_.reset();
+        utterance_pending_ = false;
+        return event;
+    }
+
+    VoskRecognizer* recognizer_;
+    PipelineConfig config_;
+    VoiceActivityGate vad_;
+    std::vector<int16_t> vad_out_;
+    EarlyFireState early_;
+    bool utterance_pending_ = false; // Audio fed since the last result
+};
@@ -0,0 +1,266 @@
+// Offline replay benchmark for the recognition pipeline.
+//
+// Replays a directory of 16 kHz mono 16-bit WAV files through the same
+// RecognitionPipeline as main.cpp (chunking, optional VAD gate,
+// vosk_recognizer_accept_waveform, early firing) and the same result
+// handling (CommandEvidence, command_verdict and the confidence gate from
+// command_gate.h) as fast as the decoder runs, without a microphone or a
+// robot. Used to compare models, chunk sizes, grammar and gate settings
+// reproducibly on a headless box.
+//
+// Every file is an independent utterance: a command the gate holds is
+// counted as not sent (the user would have been asked to repeat it).
+//
+// Expected commands come from --labels (lines "<file.wav> <spoken text>") or,
+// without a label, from the file name: "ileri_03.wav" -> "ileri 03" -> 'I'.
+// Files whose text holds no command (noise, chatter) count as negatives.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include <vosk_api.h>
+#include "command_gate.h"
+#include "recognition_pipeline.h"
+#include "wav_dataset.h"
+
+#define SAMPLE_RATE 16000
+#define FRAMES_PER_BUFFER 4000 // Default decoder chunk (250 ms), same as main.cpp
+#define MODEL_PATH "../../model"
+
+namespace fs = std::filesystem;
+
+// End of the last frame the VAD would call loud, in samples (the point the
+// speaker stops talking); the whole file if it never gets loud
+size_t speech_end(const std::vector<int16_t>& samples, const VadConfig& vad) {
+    size_t end = samples.size();
+    int16_t prev = 0;
+    for (size_t i = 0; i + vad.frame_size <= samples.size(); i += vad.frame_size) {
+        FrameFeatures f = frame_features(&samples[i], vad.frame_size, prev);
+        prev = samples[i + vad.frame_size - 1];
+        if (std::sqrt((double)f.energy / vad.frame_size) >= vad.rms_threshold) end = i + vad.frame_size;
+    }
+    return end;
+}
+
+// Nearest-rank percentile of unsorted values (p in 0..1)
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(p * values.size());
+    size_t index = rank > 0 ? rank - 1 : 0;
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct ReplayStats {
+    size_t files = 0;
+    double audio_s = 0.0;
+    double decode_s = 0.0;
+    std::vector<double> chunk_ms;    // Decode time of every chunk
+    std::vector<double> command_ms;  // Speech end to command, per detected command
+    CommandScore score;
+    int held_expected = 0;           // Gate held the expected command (user must repeat)
+    int held_other = 0;              // Gate held a wrong or unwanted command
+};
+
+int main(int argc, char** argv) {
+    RecognizerMode mode = RecognizerMode::FullVocabulary;
+    PipelineConfig pipeline_config;
+    size_t chunk_frames = FRAMES_PER_BUFFER;
+    bool confidence_gate = false;
+    int nbest = 0; // Alternatives requested from Vosk, 0 = off
+    std::string model_path = MODEL_PATH;
+    std::string labels_path;
+    std::string wav_dir;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--grammar") == 0) {
+            mode = RecognizerMode::CommandGrammar;
+        } else if (strcmp(argv[i], "--early-fire") == 0) {
+            pipeline_config.early_fire = true;
+        } else if (strcmp(argv[i], "--vad") == 0) {
+            pipeline_config.use_vad = true;
+        } else if (strcmp(argv[i], "--confidence") == 0) {
+            confidence_gate = true;
+        } else if (strcmp(argv[i], "--nbest") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 1) {
+            nbest = atoi(argv[++i]);
+            confidence_gate = true;
+        } else if (strcmp(argv[i], "--chunk-ms") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            chunk_frames = (size_t)atoi(argv[++i]) * SAMPLE_RATE / 1000;
+        } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "--labels") == 0 && i + 1 < argc) {
+            labels_path = argv[++i];
+        } else if (argv[i][0] != '-' && wav_dir.empty()) {
+            wav_dir = argv[i];
+        } else {
+            wav_dir.clear();
+            break;
+        }
+    }
+    if (wav_dir.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <wav_dir> [--grammar] [--early-fire] [--vad] [--confidence] [--nbest N] [--chunk-ms N]"
+                  << " [--model DIR] [--labels FILE]" << std::endl;
+        std::cerr << "  --chunk-ms N       Decoder chunk in ms, default " << FRAMES_PER_BUFFER * 1000 / SAMPLE_RATE
+                  << std::endl;
+        std::cerr << "  --confidence       Send only when the command word's conf clears its threshold" << std::endl;
+        std::cerr << "  --nbest N          Gate on the margin over N-best alternatives (N >= 2)" << std::endl;
+        std::cerr << "  --labels FILE      Lines '<file.wav> <spoken text>'; default: text from the file name"
+                  << std::endl;
+        return -1;
+    }
+
+    std::error_code ec;
+    std::vector<std::string> files = list_wav_files(wav_dir, ec);
+    if (ec || files.empty()) {
+        std::cerr << "ERROR: no .wav files in '" << wav_dir << "'" << (ec ? ": " + ec.message() : "") << std::endl;
+        return -1;
+    }
+    std::map<std::string, std::string> labels;
+    if (!labels_path.empty()) labels = load_labels(labels_path);
+
+    vosk_set_log_level(-1);
+    auto load_start = std::chrono::steady_clock::now();
+    VoskModel* model = vosk_model_new(model_path.c_str());
+    if (model == nullptr) {
+        std::cerr << "ERROR: '" << model_path << "' directory not found or model is invalid!" << std::endl;
+        return -1;
+    }
+    double load_s = seconds_since(load_start);
+    VoskRecognizer* recognizer = create_recognizer(model, mode, SAMPLE_RATE);
+    if (recognizer == nullptr) {
+        std::cerr << "ERROR: Recognizer could not be created (" << mode_name(mode) << ")!" << std::endl;
+        return -1;
+    }
+    if (confidence_gate) enable_command_evidence(recognizer, nbest);
+    pipeline_config.early_stop_only = confidence_gate; // As main.cpp: partials carry no conf
+    RecognitionPipeline pipeline(recognizer, pipeline_config, chunk_frames);
+    CommandEvidence evidence;
+    ConfirmationGate gate;
+
+    std::cout << "Replaying " << files.size() << " files: " << mode_name(mode) << ", chunk "
+              << chunk_frames * 1000 / SAMPLE_RATE << " ms" << (pipeline_config.use_vad ? ", VAD" : "")
+              << (pipeline_config.early_fire ? ", early fire" : "");
+    if (confidence_gate) {
+        std::cout << ", gate on " << (nbest > 0 ? "n-best margin over " + std::to_string(nbest) + " alternatives"
+                                                : std::string("word confidence"));
+    }
+    std::cout << std::endl;
+
+    ReplayStats stats;
+    std::vector<int16_t> samples;
+    for (const std::string& file : files) {
+        fs::path path(file);
+        std::string error;
+        samples.clear();
+        if (!read_wav(file, samples, error)) {
+            std::cerr << "Skipping " << path.filename().string() << ": " << error << std::endl;
+            continue;
+        }
+        char expected = expected_command(file, labels);
+        size_t end_of_speech = speech_end(samples, pipeline_config.vad);
+
+        // Every chunk is decoded as soon as the previous one is done; a command
+        // found in the chunk ending at sample n would have been sent, live,
+        // n - end_of_speech samples after the speaker stopped plus the decode time
+        pipeline.reset();
+        gate.reset();
+        char sent = 0;
+        char held = 0;
+        double command_s = 0.0;
+        auto on_event = [&](const DecodeEvent& event, size_t position, double decode_s) {
+            char command = 0;
+            if (event.kind == DecodeEvent::EarlyFire) {
+                command = event.command;
+            } else if (event.kind == DecodeEvent::Result) {
+                evidence.parse(event.json);
+                int64_t now_ns = (int64_t)position * 1000000000LL / SAMPLE_RATE; // Audio time
+                CommandVerdict verdict = command_verdict(evidence, event.already_sent,
+                                                         confidence_gate ? &gate : nullptr, now_ns);
+                if (verdict == CommandVerdict::Send) command = evidence.command();
+                if (verdict == CommandVerdict::Confirm && held == 0) held = evidence.command();
+            }
+            if (command == 0 || sent != 0) return; // The first command sent is the one the robot acts on
+            sent = command;
+            command_s = ((double)position - (double)end_of_speech) / SAMPLE_RATE + decode_s;
+        };
+
+        for (size_t pos = 0; pos < samples.size(); pos += chunk_frames) {
+            size_t frames = std::min(chunk_frames, samples.size() - pos);
+            auto start = std::chrono::steady_clock::now();
+            DecodeEvent event = pipeline.decode(&samples[pos], frames);
+            double decode_s = seconds_since(start);
+            stats.chunk_ms.push_back(decode_s * 1000);
+            stats.decode_s += decode_s;
+            on_event(event, pos + frames, decode_s);
+        }
+        auto start = std::chrono::steady_clock::now();
+        DecodeEvent last = pipeline.flush();
+        double flush_s = seconds_since(start);
+        stats.decode_s += flush_s;
+        on_event(last, samples.size(), flush_s);
+
+        stats.files++;
+        stats.audio_s += (double)samples.size() / SAMPLE_RATE;
+        if (sent != 0) stats.command_ms.push_back(command_s * 1000);
+        stats.score.add(expected, sent);
+        if (held != 0 && sent == 0) (held == expected ? stats.held_expected : stats.held_other)++;
+
+        std::cout << path.filename().string() << ": expected " << command_label(expected) << ", sent "
+                  << command_label(sent);
+        if (sent != 0) std::cout << " (" << (int)std::lround(command_s * 1000) << " ms after speech end)";
+        if (held != 0 && sent == 0) std::cout << " (held " << held << ", repeat asked)";
+        std::cout << std::endl;
+    }
+
+    if (stats.files == 0) {
+        std::cerr << "ERROR: no readable WAV files" << std::endl;
+        return -1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage); // ru_maxrss is in KiB on Linux
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "\nModel load: " << (int)(load_s * 1000) << " ms" << std::endl;
+    std::cout << "Audio: " << stats.files << " files, " << stats.audio_s << " s; decode " << stats.decode_s
+              << " s; RTF " << (stats.audio_s > 0 ? stats.decode_s / stats.audio_s : 0.0) << std::endl;
+    std::cout << "Chunk decode (ms): chunks=" << stats.chunk_ms.size()
+              << " p50=" << percentile(stats.chunk_ms, 0.50)
+              << " p90=" << percentile(stats.chunk_ms, 0.90)
+              << " p99=" << percentile(stats.chunk_ms, 0.99)
+              << " max=" << percentile(stats.chunk_ms, 1.0) << std::endl;
+    std::cout << "Time to command (ms after speech end): commands=" << stats.command_ms.size()
+              << " p50=" << percentile(stats.command_ms, 0.50)
+              << " p90=" << percentile(stats.command_ms, 0.90)
+              << " max=" << percentile(stats.command_ms, 1.0) << std::endl;
+    stats.score.print(std::cout);
+    if (confidence_gate) {
+        std::cout << "Confidence gate: passed=" << gate.stats().confident << " held=" << gate.stats().held
+                  << " (expected command held: " << stats.held_expected
+                  << ", wrong or unwanted command held: " << stats.held_other << ")" << std::endl;
+    }
+    std::cout << std::setprecision(3);
+    if (pipeline_config.use_vad) {
+        std::cout << "VAD stats: frames_gated=" << pipeline.vad_stats().frames_gated
+                  << " frames_decoded=" << pipeline.vad_stats().frames_decoded << std::endl;
+    }
+    std::cout << "Peak RSS: " << usage.ru_maxrss / 1024 << " MB" << std::endl;
+
+    vosk_recognizer_free(recognizer);
+    vosk_model_free(model);
+    return 0;
+}
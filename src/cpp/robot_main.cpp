@@ -3,176 +3,315 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
-#include <thread>
-#include <atomic>
-#include <chrono>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+
+#include "realtime.h"
+#include "command_sequence.h"
+#include "motion_packet.h"
 
 // --- CONFIGURATION ---
 #define MOTION_IP "192.168.1.120" // Robot IP address (192.168.1.120 or 192.168.2.1)
 #define MOTION_PORT 43893         
 #define LISTEN_PORT 5001          
+#define CONTROL_PERIOD_NS 20000000 // 50 Hz heartbeat / velocity tick
+#define TICK_DEADLINE_NS 2000000   // A tick waking later than this counts as a deadline miss
+#define MODE_SWITCH_DELAY_NS 50000000 // Robot needs ~50 ms between mode switch commands
 
-// --- PROTOCOL STRUCTURES ---
-struct CommandHead {
-    uint32_t code;
-    uint32_t parameters_size;
-    uint32_t type;
-};
+// Global Variables
+// Everything below is owned by the single event loop thread.
+int cmd_fd;    // Bound to LISTEN_PORT, receives voice commands
+int motion_fd; // Connected to the motion host: sends commands, receives replies
+struct sockaddr_in motion_addr;
+double target_velocity_x = 0.0; 
+bool is_moving = false;         
+TickStats tick_stats;
+CommandSequencer sequencer;
 
-const uint32_t kDataSize = 256;
-struct Command {
-    CommandHead head;
-    uint32_t data[kDataSize];
+// Replies / state packets received from the motion host
+struct MotionReplyStats {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint32_t last_code = 0; // CommandHead.code of the latest reply
 };
+MotionReplyStats motion_replies;
 
-// --- COMMAND CODES FROM DOCUMENTATION ---
-const uint32_t CMD_HEARTBEAT     = 0x21040001; // [cite: 1876]
-const uint32_t CMD_STAND_SIT     = 0x21010202; // [cite: 1917] Stand/Sit Toggle
-const uint32_t CMD_MOVE_MODE     = 0x21010D06; //  Move Mode (Walking Mode)
-const uint32_t CMD_NAV_MODE      = 0x21010C03; //  Navigation Mode (Listen to PC Mode)
-const uint32_t CMD_VEL_X         = 0x0140;     // [cite: 1996] X Velocity (Forward/Backward)
-const uint32_t CMD_HELLO         = 0x21010507; // [cite: 1948] Hello/Greeting
-
-// Global Variables
-int sockfd;
-struct sockaddr_in motion_addr;
-std::atomic<double> target_velocity_x(0.0); 
-std::atomic<bool> is_moving(false);         
+// Reused packet buffers: the heartbeat never changes, the velocity packet
+// only gets its payload rewritten each tick
+MotionPacket heartbeat_packet;
+MotionPacket velocity_packet;
+MotionPacket scratch_packet;
 
 // --- HELPER FUNCTIONS ---
+void send_packet(const MotionPacket& packet) {
+    send(motion_fd, packet.data(), packet.size(), 0);
+}
+
 void send_simple_cmd(uint32_t code, uint32_t value = 0) {
-    CommandHead cmd = {0};
-    cmd.code = code;
-    cmd.parameters_size = value; 
-    cmd.type = 0;                
-    sendto(sockfd, &cmd, sizeof(cmd), 0, (struct sockaddr*)&motion_addr, sizeof(motion_addr));
+    scratch_packet.set_simple_runtime(code, value);
+    send_packet(scratch_packet);
 }
 
 void send_complex_cmd_double(uint32_t code, double value) {
-    Command cmd = {0};
-    cmd.head.code = code;
-    cmd.head.parameters_size = sizeof(double); 
-    cmd.head.type = 1;                         
-    memcpy(cmd.data, &value, sizeof(double));
-    sendto(sockfd, &cmd, sizeof(CommandHead) + cmd.head.parameters_size, 0, 
-           (struct sockaddr*)&motion_addr, sizeof(motion_addr));
+    scratch_packet.set_payload_runtime(code, &value, sizeof(value));
+    send_packet(scratch_packet);
 }
 
-// --- CONTROL LOOP (50Hz) ---
-void control_loop() {
+// Runs one step of a command sequence
+void execute_step(const SequenceStep& step) {
+    switch (step.kind) {
+        case SequenceStep::SendCommand:
+            send_simple_cmd(step.code, 0);
+            break;
+        case SequenceStep::SetMotion:
+            target_velocity_x = step.velocity;
+            is_moving = step.moving;
+            break;
+        case SequenceStep::SendVelocity:
+            send_complex_cmd_double(step.code, step.velocity);
+            break;
+    }
+}
+
+// --- CONTROL TICK (50Hz) ---
+// Driven by a timerfd on absolute deadlines so the heartbeat period does not drift.
+// Pending command sequence steps run at the start of each tick.
+void control_tick() {
+    // 0. Due steps of the current command sequence
+    sequencer.tick(now_ns(), execute_step);
+
+    // 1. Heartbeat (Required)
+    // 2. If moving, continuously send velocity data
+    // Both go out in a single sendmmsg() call
+    if (is_moving) {
+        velocity_packet.update<CMD_VEL_X>(target_velocity_x);
+        const MotionPacket* packets[] = {&heartbeat_packet, &velocity_packet};
+        send_packets(motion_fd, packets, 2);
+    } else {
+        send_packet(heartbeat_packet);
+    }
+}
+
+// Maps a voice command to its timed sequence. Returns false for unknown commands.
+bool build_sequence(char command, CommandSequence& seq) {
+    switch (command) {
+        case 'K': // STAND UP (or Sit)
+            std::cout << ">>> COMMAND: Stand/Sit Toggle" << std::endl;
+            // Switch to Navigation Mode before standing to listen for commands
+            seq.motion(0.0, false)
+               .send<CMD_NAV_MODE>(MODE_SWITCH_DELAY_NS)
+               .send<CMD_STAND_SIT>();
+            return true;
+        
+        case 'O': // SIT DOWN (Same command toggles in documentation)
+             std::cout << ">>> COMMAND: Sit (Stand/Sit Toggle)" << std::endl;
+             seq.motion(0.0, false)
+                .send<CMD_STAND_SIT>();
+             return true;
+
+        case 'I': // FORWARD
+            std::cout << ">>> COMMAND: Move Forward (Preparing...)" << std::endl;
+            // STEP 1: Switch to Navigation Mode (Listen to me), wait 50ms
+            // STEP 2: Switch to Move Mode (Walking mode), wait 50ms
+            // STEP 3: Set velocity and start loop
+            seq.send<CMD_NAV_MODE>(MODE_SWITCH_DELAY_NS)
+               .send<CMD_MOVE_MODE>(MODE_SWITCH_DELAY_NS)
+               .motion(0.3, true); // 0.3 m/s forward
+            std::cout << ">>> Setting velocity: 0.3 m/s" << std::endl;
+            return true;
+
+        case 'G': // BACKWARD
+            std::cout << ">>> COMMAND: Move Backward" << std::endl;
+            seq.send<CMD_NAV_MODE>(MODE_SWITCH_DELAY_NS)
+               .send<CMD_MOVE_MODE>(MODE_SWITCH_DELAY_NS)
+               .motion(-0.3, true); // Negative velocity = Backward
+            return true;
+        
+        case '0': // STOP
+            std::cout << ">>> COMMAND: Stop" << std::endl;
+            // Manually send 0 velocity once to ensure stop
+            seq.motion(0.0, false)
+               .send_velocity<CMD_VEL_X>(0.0);
+            return true;
+
+        case 'H': // HELLO
+            std::cout << ">>> COMMAND: Hello (Works when sitting)" << std::endl;
+            seq.motion(target_velocity_x, false)
+               .send<CMD_HELLO>();
+            return true;
+    }
+    return false;
+}
+
+// --- EVENT HANDLERS ---
+// Sockets are non-blocking: drain until EAGAIN.
+void handle_command_socket() {
+    char buffer[1024];
+    struct sockaddr_in client_addr;
+
     while (true) {
-        // 1. Heartbeat (Required)
-        send_simple_cmd(CMD_HEARTBEAT, 0);
+        socklen_t addr_len = sizeof(client_addr);
+        ssize_t n = recvfrom(cmd_fd, buffer, sizeof(buffer), 0, (struct sockaddr *)&client_addr, &addr_len);
+        if (n < 0) break;
+        if (n == 0) continue;
+
+        char command = buffer[0];
+        std::cout << "Received Command: " << command << std::endl;
 
-        // 2. If moving, continuously send velocity data
-        if (is_moving) {
-            send_complex_cmd_double(CMD_VEL_X, target_velocity_x.load());
+        // Each command becomes a timed sequence; submitting replaces any steps
+        // still pending from the previous one. Its first step runs right away.
+        CommandSequence seq;
+        if (build_sequence(command, seq)) {
+            sequencer.submit(seq);
+            sequencer.tick(now_ns(), execute_step);
         }
+    }
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(20)); 
+void handle_motion_socket() {
+    char buffer[2048];
+    while (true) {
+        ssize_t n = recv(motion_fd, buffer, sizeof(buffer), 0);
+        if (n < 0) break;
+        motion_replies.packets++;
+        motion_replies.bytes += n;
+        if (n >= (ssize_t)sizeof(CommandHead)) {
+            CommandHead head;
+            memcpy(&head, buffer, sizeof(head));
+            motion_replies.last_code = head.code;
+        }
     }
 }
 
-int main() {
-    // 1. UDP Socket Setup
-    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool epoll_watch(int epfd, int fd) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+int main(int argc, char** argv) {
+    int rt_priority = 0; // 0 = normal scheduling
+    int cpu = -1;        // -1 = no pinning
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rt-priority") == 0 && i + 1 < argc) {
+            rt_priority = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu = atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--rt-priority 1-99] [--cpu N]" << std::endl;
+            return -1;
+        }
+    }
+
+    // 1. Command Socket Setup (voice front-end -> controller)
+    if ((cmd_fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
         perror("Socket error");
         return -1;
     }
 
-    memset(&motion_addr, 0, sizeof(motion_addr));
-    motion_addr.sin_family = AF_INET;
-    motion_addr.sin_port = htons(MOTION_PORT);
-    motion_addr.sin_addr.s_addr = inet_addr(MOTION_IP);
-
-    struct sockaddr_in server_addr, client_addr;
+    struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(LISTEN_PORT);
 
-    if (bind(sockfd, (const struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(cmd_fd, (const struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
         perror("Bind error");
         return -1;
     }
 
+    // 2. Motion Socket Setup (controller <-> robot motion host)
+    if ((motion_fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("Socket error");
+        return -1;
+    }
+
+    memset(&motion_addr, 0, sizeof(motion_addr));
+    motion_addr.sin_family = AF_INET;
+    motion_addr.sin_port = htons(MOTION_PORT);
+    motion_addr.sin_addr.s_addr = inet_addr(MOTION_IP);
+
+    // Connected UDP: plain send(), and only the motion host's replies are received
+    if (connect(motion_fd, (const struct sockaddr *)&motion_addr, sizeof(motion_addr)) < 0) {
+        perror("Connect error");
+        return -1;
+    }
+
+    // 3. Shutdown signals arrive as events instead of interrupting calls
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    // 4. Control tick timer and prebuilt tick packets
+    heartbeat_packet.set_simple<CMD_HEARTBEAT>(0);
+    velocity_packet.set<CMD_VEL_X>(0.0);
+    PeriodicTimer timer(CONTROL_PERIOD_NS, TICK_DEADLINE_NS, tick_stats);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (signal_fd < 0 || timer.fd() < 0 || epfd < 0 ||
+        !set_nonblocking(cmd_fd) || !set_nonblocking(motion_fd) ||
+        !epoll_watch(epfd, cmd_fd) || !epoll_watch(epfd, motion_fd) ||
+        !epoll_watch(epfd, timer.fd()) || !epoll_watch(epfd, signal_fd)) {
+        perror("Event loop setup error");
+        return -1;
+    }
+
+    // The event loop thread is the control thread
+    configure_realtime_thread(pthread_self(), rt_priority, cpu);
+
     std::cout << "Lite3 Controller (Documentation Approved V3) Started!" << std::endl;
-    
-    std::thread ctrl_thread(control_loop);
-    ctrl_thread.detach();
 
-    char buffer[1024];
-    socklen_t addr_len = sizeof(client_addr);
+    // --- EVENT LOOP ---
+    bool running = true;
+    struct epoll_event events[8];
+    while (running) {
+        int n = epoll_wait(epfd, events, 8, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
 
-    while (true) {
-        int n = recvfrom(sockfd, (char *)buffer, 1024, MSG_WAITALL, 
-                         (struct sockaddr *)&client_addr, &addr_len);
-        
-        if (n > 0) {
-            char command = buffer[0];
-            std::cout << "Received Command: " << command << std::endl;
-
-            switch (command) {
-                case 'K': // STAND UP (or Sit)
-                    std::cout << ">>> COMMAND: Stand/Sit Toggle" << std::endl;
-                    is_moving = false; 
-                    target_velocity_x = 0.0;
-                    // Switch to Navigation Mode before standing to listen for commands
-                    send_simple_cmd(CMD_NAV_MODE, 0); 
-                    usleep(50000); 
-                    send_simple_cmd(CMD_STAND_SIT, 0);
-                    break;
-                
-                case 'O': // SIT DOWN (Same command toggles in documentation)
-                     std::cout << ">>> COMMAND: Sit (Stand/Sit Toggle)" << std::endl;
-                     is_moving = false;
-                     target_velocity_x = 0.0;
-                     send_simple_cmd(CMD_STAND_SIT, 0);
-                     break;
-
-                case 'I': // FORWARD
-                    std::cout << ">>> COMMAND: Move Forward (Preparing...)" << std::endl;
-                    
-                    // STEP 1: Switch to Navigation Mode (Listen to me)
-                    send_simple_cmd(CMD_NAV_MODE, 0); 
-                    usleep(50000); // Wait 50ms
-
-                    // STEP 2: Switch to Move Mode (Walking mode)
-                    send_simple_cmd(CMD_MOVE_MODE, 0);
-                    usleep(50000);
-
-                    // STEP 3: Set velocity and start loop
-                    target_velocity_x = 0.3; // 0.3 m/s forward
-                    is_moving = true;
-                    std::cout << ">>> Setting velocity: 0.3 m/s" << std::endl;
-                    break;
-
-                case 'G': // BACKWARD
-                    std::cout << ">>> COMMAND: Move Backward" << std::endl;
-                    send_simple_cmd(CMD_NAV_MODE, 0);
-                    usleep(50000);
-                    send_simple_cmd(CMD_MOVE_MODE, 0);
-                    usleep(50000);
-                    
-                    target_velocity_x = -0.3; // Negative velocity = Backward
-                    is_moving = true;
-                    break;
-                
-                case '0': // STOP
-                    std::cout << ">>> COMMAND: Stop" << std::endl;
-                    target_velocity_x = 0.0;
-                    is_moving = false; 
-                    // Manually send 0 velocity once to ensure stop
-                    send_complex_cmd_double(CMD_VEL_X, 0.0);
-                    break;
-
-                case 'H': // HELLO
-                    std::cout << ">>> COMMAND: Hello (Works when sitting)" << std::endl;
-                    is_moving = false;
-                    send_simple_cmd(CMD_HELLO, 0);
-                    break;
+        // The tick is handled first so heartbeats are never delayed by command handling
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == timer.fd() && timer.on_readable()) {
+                control_tick();
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == cmd_fd) {
+                handle_command_socket();
+            } else if (fd == motion_fd) {
+                handle_motion_socket();
+            } else if (fd == signal_fd) {
+                running = false;
             }
         }
     }
+
+    tick_stats.print(std::cout);
+    std::cout << "Motion host replies: packets=" << motion_replies.packets
+              << " bytes=" << motion_replies.bytes
+              << " last_code=0x" << std::hex << motion_replies.last_code << std::dec << std::endl;
+
+    close(epfd);
+    close(signal_fd);
+    close(motion_fd);
+    close(cmd_fd);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// --- COSINE SIMILARITY KERNEL ---
+// One pass computing dot(a, b), |a|^2 and |b|^2 with 4-wide SIMD.
+inline float cosine_similarity(const float* a, const float* b, size_t n) {
+    float dot = 0.0f, na = 0.0f, nb = 0.0f;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128 vdot = _mm_setzero_ps(), vna = _mm_setzero_ps(), vnb = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        vdot = _mm_add_ps(vdot, _mm_mul_ps(va, vb));
+        vna = _mm_add_ps(vna, _mm_mul_ps(va, va));
+        vnb = _mm_add_ps(vnb, _mm_mul_ps(vb, vb));
+    }
+    float t[4];
+    _mm_storeu_ps(t, vdot); dot = t[0] + t[1] + t[2] + t[3];
+    _mm_storeu_ps(t, vna);  na = t[0] + t[1] + t[2] + t[3];
+    _mm_storeu_ps(t, vnb);  nb = t[0] + t[1] + t[2] + t[3];
+#elif defined(__ARM_NEON)
+    float32x4_t vdot = vdupq_n_f32(0.0f), vna = vdupq_n_f32(0.0f), vnb = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t va = vld1q_f32(a + i);
+        float32x4_t vb = vld1q_f32(b + i);
+        vdot = vmlaq_f32(vdot, va, vb);
+        vna = vmlaq_f32(vna, va, va);
+        vnb = vmlaq_f32(vnb, vb, vb);
+    }
+    float t[4];
+    vst1q_f32(t, vdot); dot = t[0] + t[1] + t[2] + t[3];
+    vst1q_f32(t, vna);  na = t[0] + t[1] + t[2] + t[3];
+    vst1q_f32(t, vnb);  nb = t[0] + t[1] + t[2] + t[3];
+#endif
+
+    for (; i < n; i++) {
+        dot += a[i] * b[i];
+        na += a[i] * a[i];
+        nb += b[i] * b[i];
+    }
+    if (na <= 0.0f || nb <= 0.0f) return 0.0f;
+    return dot / std::sqrt(na * nb);
+}
+
+// --- ENROLLED OWNER VECTOR ---
+// Stored as whitespace-separated floats in a text file.
+inline bool load_speaker_vector(const std::string& path, std::vector<float>& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    out.clear();
+    float v;
+    while (in >> v) out.push_back(v);
+    return !out.empty();
+}
+
+inline bool save_speaker_vector(const std::string& path, const std::vector<float>& vec) {
+    std::ofstream out(path);
+    if (!out) return false;
+    for (size_t i = 0; i < vec.size(); i++) {
+        out << vec[i] << (i + 1 < vec.size() ? ' ' : '\n');
+    }
+    return (bool)out;
+}
+
+// Averages x-vectors from several enrollment utterances
+struct SpeakerEnrollment {
+    std::vector<float> sum;
+    int utterances = 0;
+
+    void add(const std::vector<float>& vec) {
+        if (sum.empty()) sum.assign(vec.size(), 0.0f);
+        if (vec.size() != sum.size()) return;
+        // Normalize first so long utterances don't dominate
+        float norm = 0.0f;
+        for (float v : vec) norm += v * v;
+        norm = std::sqrt(norm);
+        if (norm <= 0.0f) return;
+        for (size_t i = 0; i < vec.size(); i++) sum[i] += vec[i] / norm;
+        utterances++;
+    }
+
+    std::vector<float> result() const {
+        std::vector<float> mean(sum);
+        for (float& v : mean) v /= (utterances ? utterances : 1);
+        return mean;
+    }
+};
+
+// --- VERIFIER ---
+// The speaker vector comes from the result's "spk" array, read in the same
+// pass as the command (SpeakerEvidence in command_gate.h).
+struct SpeakerVerifier {
+    std::vector<float> owner;
+    float threshold = 0.0f;
+
+    // Score of a result's speaker vector against the owner; -1 if there is
+    // no usable vector (too short utterance, size mismatch)
+    float score(const std::vector<float>& spk) const {
+        if (spk.empty() || spk.size() != owner.size()) return -1.0f;
+        return cosine_similarity(owner.data(), spk.data(), owner.size());
+    }
+};
@@ -0,0 +1,494 @@
+// Multi-stream recognition server for a base station.
+//
+// Each robot streams raw 16 kHz mono int16 little-endian PCM over one TCP
+// connection, e.g.
+//     arecord -q -f S16_LE -r 16000 -c 1 -t raw | nc <base-station> 5002
+// Detected commands are sent back as a single UDP byte to the robot's
+// controller (robot_main.cpp, COMMAND_PORT) at the connection's address.
+//
+// One VoskModel is loaded and shared by all streams; every stream gets its
+// own VoskRecognizer and RecognitionPipeline. Decoding runs on a fixed pool
+// of worker threads: a stream with a full chunk waits in a FIFO ready queue,
+// a worker decodes one chunk of it and puts it back at the tail if more is
+// buffered, so a backlog on one stream never starves the others. A stream
+// that falls more than MAX_LAG_MS behind skips its oldest audio, so the
+// commands it sends stay current.
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <vosk_api.h>
+#include "audio_ring.h"
+#include "command_gate.h"
+#include "recognition_pipeline.h"
+
+// --- CONFIGURATION ---
+#define SAMPLE_RATE 16000
+#define STREAM_PORT 5002        // TCP port robots stream audio to
+#define COMMAND_PORT 5001       // robot_main.cpp LISTEN_PORT on each robot
+#define MODEL_PATH "../../model"
+#define CHUNK_FRAMES 1600       // Default decode quantum per turn (100 ms)
+#define RING_SECONDS 4          // Per-stream buffer; when full (workers stalled) incoming audio is dropped
+#define MAX_LAG_MS 2000         // A stream further behind drops its oldest audio...
+#define CATCH_UP_MS 500         // ...down to this much, and starts a new utterance
+#define STATS_INTERVAL_S 10     // Periodic per-stream report
+#define MAX_EVENTS 64
+
+std::mutex log_mutex; // Workers and the event loop print whole lines
+
+// --- STREAM ---
+// Producer side (ring writes, carry byte) belongs to the event loop thread;
+// the recognizer and pipeline to whichever worker currently holds the
+// stream (at most one). The scheduling flags are guarded by the pool mutex.
+struct Stream {
+    Stream(int stream_id, int socket_fd, const sockaddr_in& peer, VoskRecognizer* stream_recognizer,
+           const PipelineConfig& config, size_t chunk_frames)
+        : id(stream_id), fd(socket_fd), command_addr(peer), recognizer(stream_recognizer),
+          pipeline(stream_recognizer, config, chunk_frames), ring(RING_SECONDS * SAMPLE_RATE) {
+        command_addr.sin_port = htons(COMMAND_PORT);
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip));
+        name = ip;
+    }
+
+    ~Stream() { vosk_recognizer_free(recognizer); }
+
+    int id;
+    int fd;
+    std::string name;
+    sockaddr_in command_addr;
+    VoskRecognizer* recognizer;
+    RecognitionPipeline pipeline;
+    CommandEvidence evidence;  // Owner thread
+    ConfirmationGate gate;     // Owner thread; used with --confidence / --nbest
+    AudioRing ring;
+
+    // Event loop only
+    unsigned char carry = 0; // Odd byte of a sample split across two reads
+    bool has_carry = false;
+
+    // Pool mutex
+    bool queued = false;
+    bool busy = false;
+    bool closed = false;
+
+    // Written by the owner thread, read by the stats report
+    std::atomic<uint64_t> samples_received{0};
+    std::atomic<uint64_t> samples_decoded{0};
+    std::atomic<uint64_t> dropped_samples{0};  // Skipped (over MAX_LAG_MS behind) or ring full
+    std::atomic<int64_t> decode_ns{0};
+    std::atomic<size_t> max_queue{0};          // Peak buffered samples
+    std::atomic<uint64_t> commands{0};
+    std::atomic<uint64_t> held{0};             // Held by the confidence gate
+
+    double rtf() const {
+        uint64_t decoded = samples_decoded.load(std::memory_order_relaxed);
+        return decoded ? decode_ns.load(std::memory_order_relaxed) / 1e9 / ((double)decoded / SAMPLE_RATE) : 0.0;
+    }
+};
+
+void print_stream_stats(const Stream& s, const char* label) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    std::cout << std::fixed << std::setprecision(3)
+              << "[stream " << s.id << " " << s.name << "] " << label
+              << " audio=" << (double)s.samples_received.load() / SAMPLE_RATE << "s"
+              << " rtf=" << s.rtf()
+              << " queue=" << s.ring.available() * 1000 / SAMPLE_RATE << "ms"
+              << " max_queue=" << s.max_queue.load() * 1000 / SAMPLE_RATE << "ms"
+              << " dropped=" << s.dropped_samples.load()
+              << " commands=" << s.commands.load()
+              << " held=" << s.held.load() << std::endl;
+}
+
+// --- COMMAND OUTPUT ---
+int command_fd = -1;
+
+void send_command(Stream& s, char command, const char* how) {
+    sendto(command_fd, &command, 1, 0, (const struct sockaddr*)&s.command_addr, sizeof(s.command_addr));
+    s.commands.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(log_mutex);
+    std::cout << "[stream " << s.id << " " << s.name << "] " << how << ": " << command << std::endl;
+}
+
+bool use_gate = false; // --confidence / --nbest
+
+// Final results go through the same CommandEvidence / command_verdict code
+// as main.cpp's process_result
+void handle_event(Stream& s, const DecodeEvent& event) {
+    if (event.kind == DecodeEvent::EarlyFire) {
+        send_command(s, event.command, "Early fire (partial)");
+    } else if (event.kind == DecodeEvent::Result) {
+        s.evidence.parse(event.json);
+        if (s.evidence.text.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            std::cout << "[stream " << s.id << " " << s.name << "] Detected: " << s.evidence.text << std::endl;
+        }
+        CommandVerdict verdict = command_verdict(s.evidence, event.already_sent, use_gate ? &s.gate : nullptr,
+                                                 monotonic_ns());
+        if (verdict == CommandVerdict::Send) {
+            send_command(s, s.evidence.command(), "Sent");
+        } else if (verdict == CommandVerdict::Confirm) {
+            s.held.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(log_mutex);
+            std::cout << "[stream " << s.id << " " << s.name << "] Held (low confidence, repeat to send): "
+                      << s.evidence.command() << std::endl;
+        }
+    }
+}
+
+// --- WORKER POOL ---
+class WorkerPool {
+public:
+    WorkerPool(size_t workers, size_t chunk_frames) : chunk_frames_(chunk_frames) {
+        for (size_t i = 0; i < workers; i++) threads_.emplace_back(&WorkerPool::run, this);
+    }
+
+    ~WorkerPool() { stop(); }
+
+    size_t workers() const { return threads_.size(); }
+
+    size_t ready_depth() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ready_.size();
+    }
+
+    // New audio in s (event loop thread): queue it if a chunk is ready
+    void notify(Stream* s) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (s->ring.available() >= chunk_frames_) enqueue(s);
+    }
+
+    // Connection closed: the stream is drained, flushed and freed by a worker.
+    // The caller must not touch s afterwards.
+    void close(Stream* s) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        s->closed = true;
+        enqueue(s);
+    }
+
+    // Finishes the streams already queued, then joins the workers
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_cv_.notify_all();
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+    }
+
+private:
+    // Caller holds mutex_. A busy stream is re-checked by its worker.
+    void enqueue(Stream* s) {
+        if (s->queued || s->busy) return;
+        s->queued = true;
+        ready_.push_back(s);
+        ready_cv_.notify_one();
+    }
+
+    void run() {
+        std::vector<int16_t> buffer(chunk_frames_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            ready_cv_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+            if (ready_.empty()) return; // Stopping and nothing left
+
+            Stream* s = ready_.front();
+            ready_.pop_front();
+            s->queued = false;
+            s->busy = true;
+            bool closed = s->closed;
+            lock.unlock();
+
+            catch_up(*s);
+            if (closed) {
+                // Decode what is left (including a short last chunk), then the final result
+                size_t frames;
+                while ((frames = s->ring.read(buffer.data(), chunk_frames_)) > 0) decode(*s, buffer.data(), frames);
+                handle_event(*s, s->pipeline.flush());
+                print_stream_stats(*s, "closed");
+                delete s;
+                lock.lock();
+                continue;
+            }
+
+            // One chunk per turn: streams with a backlog go to the back of the queue
+            size_t frames = s->ring.read(buffer.data(), chunk_frames_);
+            decode(*s, buffer.data(), frames);
+
+            lock.lock();
+            s->busy = false;
+            if (s->closed || s->ring.available() >= chunk_frames_) enqueue(s);
+        }
+    }
+
+    // Owner only. Over MAX_LAG_MS behind, the oldest audio is dropped: it
+    // would only produce stale commands. The recognizer is reset so the
+    // audio on both sides of the gap is not decoded as one utterance.
+    void catch_up(Stream& s) {
+        size_t backlog = s.ring.available();
+        if (backlog <= (size_t)MAX_LAG_MS * SAMPLE_RATE / 1000) return;
+        size_t skipped = s.ring.discard(backlog - (size_t)CATCH_UP_MS * SAMPLE_RATE / 1000);
+        s.dropped_samples.fetch_add(skipped, std::memory_order_relaxed);
+        s.pipeline.reset();
+        std::lock_guard<std::mutex> lock(log_mutex);
+        std::cout << "[stream " << s.id << " " << s.name << "] " << skipped * 1000 / SAMPLE_RATE
+                  << " ms behind: oldest audio skipped" << std::endl;
+    }
+
+    void decode(Stream& s, const int16_t* samples, size_t frames) {
+        auto start = std::chrono::steady_clock::now();
+        DecodeEvent event = s.pipeline.decode(samples, frames);
+        s.decode_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        s.samples_decoded.fetch_add(frames, std::memory_order_relaxed);
+        handle_event(s, event);
+    }
+
+    size_t chunk_frames_;
+    std::mutex mutex_;
+    std::condition_variable ready_cv_;
+    std::deque<Stream*> ready_; // FIFO of streams with a chunk to decode
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// --- EVENT LOOP HELPERS ---
+bool epoll_watch(int epfd, int fd) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+// Reads everything the socket has into the stream's ring.
+// Returns false when the peer closed the connection (or it failed).
+bool read_stream(Stream& s) {
+    int16_t samples[4096];
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(samples);
+    while (true) {
+        size_t offset = 0;
+        if (s.has_carry) {
+            bytes[0] = s.carry;
+            offset = 1;
+        }
+        ssize_t n = recv(s.fd, bytes + offset, sizeof(samples) - offset, 0);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        size_t total = offset + (size_t)n;
+        size_t count = total / 2;
+        s.has_carry = (total & 1) != 0;
+        if (s.has_carry) s.carry = bytes[total - 1];
+
+        size_t written = s.ring.write(samples, count);
+        s.samples_received.fetch_add(written, std::memory_order_relaxed);
+        if (written < count) s.dropped_samples.fetch_add(count - written, std::memory_order_relaxed);
+        size_t queued = s.ring.available();
+        if (queued > s.max_queue.load(std::memory_order_relaxed)) s.max_queue.store(queued, std::memory_order_relaxed);
+    }
+}
+
+int main(int argc, char** argv) {
+    RecognizerMode mode = RecognizerMode::FullVocabulary;
+    PipelineConfig pipeline_config;
+    size_t chunk_frames = CHUNK_FRAMES;
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    int nbest = 0; // Alternatives requested from Vosk, 0 = off
+    int port = STREAM_PORT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--grammar") == 0) {
+            mode = RecognizerMode::CommandGrammar;
+        } else if (strcmp(argv[i], "--early-fire") == 0) {
+            pipeline_config.early_fire = true;
+        } else if (strcmp(argv[i], "--vad") == 0) {
+            pipeline_config.use_vad = true;
+        } else if (strcmp(argv[i], "--confidence") == 0) {
+            use_gate = true;
+        } else if (strcmp(argv[i], "--nbest") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 1) {
+            nbest = atoi(argv[++i]);
+            use_gate = true;
+        } else if (strcmp(argv[i], "--chunk-ms") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            chunk_frames = (size_t)atoi(argv[++i]) * SAMPLE_RATE / 1000;
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            workers = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            port = atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--port N] [--workers N] [--grammar] [--early-fire] [--vad] [--confidence] [--nbest N]"
+                      << " [--chunk-ms N]" << std::endl;
+            std::cerr << "  --workers N        Decoder threads, default: one per CPU" << std::endl;
+            std::cerr << "  --confidence       Send only when the command word's conf clears its threshold" << std::endl;
+            std::cerr << "  --nbest N          Gate on the margin over N-best alternatives (N >= 2)" << std::endl;
+            std::cerr << "  --chunk-ms N       Decode quantum per turn in ms, default "
+                      << CHUNK_FRAMES * 1000 / SAMPLE_RATE << std::endl;
+            return -1;
+        }
+    }
+
+    pipeline_config.early_stop_only = use_gate; // As main.cpp: partials carry no conf
+
+    // --- 1. SHARED MODEL ---
+    std::cout << "Loading model (model directory)..." << std::endl;
+    VoskModel* model = vosk_model_new(MODEL_PATH);
+    if (model == nullptr) {
+        std::cerr << "ERROR: '" << MODEL_PATH << "' directory not found or model is invalid!" << std::endl;
+        return -1;
+    }
+
+    // --- 2. SOCKETS ---
+    if ((command_fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("Socket error");
+        return -1;
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        perror("Socket error");
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in listen_addr;
+    memset(&listen_addr, 0, sizeof(listen_addr));
+    listen_addr.sin_family = AF_INET;
+    listen_addr.sin_addr.s_addr = INADDR_ANY;
+    listen_addr.sin_port = htons(port);
+    if (bind(listen_fd, (const struct sockaddr*)&listen_addr, sizeof(listen_addr)) < 0 ||
+        listen(listen_fd, 16) < 0) {
+        perror("Listen error");
+        return -1;
+    }
+
+    // Ctrl+C / SIGTERM arrive as readable events on the loop
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, nullptr); // Before the workers start, so they inherit the mask
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    int stats_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec interval;
+    memset(&interval, 0, sizeof(interval));
+    interval.it_value.tv_sec = STATS_INTERVAL_S;
+    interval.it_interval.tv_sec = STATS_INTERVAL_S;
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (signal_fd < 0 || stats_fd < 0 || timerfd_settime(stats_fd, 0, &interval, nullptr) < 0 || epfd < 0 ||
+        !epoll_watch(epfd, listen_fd) || !epoll_watch(epfd, signal_fd) || !epoll_watch(epfd, stats_fd)) {
+        perror("Event loop setup");
+        return -1;
+    }
+
+    WorkerPool pool(workers, chunk_frames);
+    std::map<int, Stream*> streams; // By socket fd; event loop only
+    int next_id = 1;
+
+    std::cout << "\nSTREAM SERVER READY on TCP port " << port << ": " << pool.workers() << " workers, "
+              << mode_name(mode) << ", chunk " << chunk_frames * 1000 / SAMPLE_RATE << " ms"
+              << (use_gate ? ", confidence gate" : "") << std::endl;
+    std::cout << "Commands go to UDP port " << COMMAND_PORT << " of each streaming host" << std::endl;
+
+    // --- 3. EVENT LOOP ---
+    bool running = true;
+    struct epoll_event events[MAX_EVENTS];
+    while (running) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == signal_fd) {
+                running = false;
+            } else if (fd == stats_fd) {
+                uint64_t expirations;
+                if (read(stats_fd, &expirations, sizeof(expirations)) < 0) continue;
+                double load = 0.0;
+                for (auto& entry : streams) {
+                    print_stream_stats(*entry.second, "stats");
+                    load += entry.second->rtf();
+                }
+                std::lock_guard<std::mutex> lock(log_mutex);
+                // Sum of per-stream RTF = busy workers needed to keep up
+                std::cout << "[server] streams=" << streams.size() << " load=" << load << "/" << pool.workers()
+                          << " workers ready_queue=" << pool.ready_depth() << std::endl;
+            } else if (fd == listen_fd) {
+                struct sockaddr_in peer;
+                socklen_t peer_len = sizeof(peer);
+                int client;
+                while ((client = accept4(listen_fd, (struct sockaddr*)&peer, &peer_len,
+                                         SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    VoskRecognizer* recognizer = create_recognizer(model, mode, SAMPLE_RATE);
+                    if (recognizer != nullptr && use_gate) enable_command_evidence(recognizer, nbest);
+                    if (recognizer == nullptr || !epoll_watch(epfd, client)) {
+                        std::cerr << "Stream rejected: recognizer or epoll setup failed" << std::endl;
+                        if (recognizer != nullptr) vosk_recognizer_free(recognizer);
+                        close(client);
+                        continue;
+                    }
+                    Stream* s = new Stream(next_id++, client, peer, recognizer, pipeline_config, chunk_frames);
+                    streams[client] = s;
+                    std::lock_guard<std::mutex> lock(log_mutex);
+                    std::cout << "[stream " << s->id << " " << s->name << "] connected" << std::endl;
+                    peer_len = sizeof(peer);
+                }
+            } else {
+                auto it = streams.find(fd);
+                if (it == streams.end()) continue;
+                Stream* s = it->second;
+                bool open = read_stream(*s);
+                if (open) {
+                    pool.notify(s);
+                } else {
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                    close(fd);
+                    streams.erase(it);
+                    pool.close(s); // Drained and freed by a worker
+                }
+            }
+        }
+    }
+
+    // --- CLEANUP ---
+    std::cout << "\nShutting down: finishing " << streams.size() << " streams..." << std::endl;
+    for (auto& entry : streams) {
+        close(entry.first);
+        pool.close(entry.second);
+    }
+    pool.stop();
+    close(epfd);
+    close(stats_fd);
+    close(signal_fd);
+    close(listen_fd);
+    close(command_fd);
+    vosk_model_free(model);
+    return 0;
+}
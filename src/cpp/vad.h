@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// --- FRAME FEATURES ---
+// Sum of squares and number of sign changes of one frame of int16 audio.
+// prev is the sample before frame[0] (for the first zero crossing).
+struct FrameFeatures {
+    uint64_t energy;
+    uint32_t zero_crossings;
+};
+
+inline FrameFeatures frame_features_scalar(const int16_t* frame, size_t n, int16_t prev) {
+    FrameFeatures f = {0, 0};
+    for (size_t i = 0; i < n; i++) {
+        f.energy += (uint64_t)((int32_t)frame[i] * frame[i]);
+        f.zero_crossings += ((frame[i] ^ prev) < 0);
+        prev = frame[i];
+    }
+    return f;
+}
+
+#if defined(__SSE2__)
+inline FrameFeatures frame_features(const int16_t* frame, size_t n, int16_t prev) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i energy = zero;    // 2 x uint64
+    __m128i crossings = zero; // 8 x int16 counters
+    size_t i = 0;
+
+    // First vector needs prev as the "previous" of frame[0]; handled in scalar
+    FrameFeatures head = frame_features_scalar(frame, n < 1 ? n : 1, prev);
+    i = n < 1 ? n : 1;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(frame + i));
+        __m128i p = _mm_loadu_si128((const __m128i*)(frame + i - 1));
+
+        // Pairwise x*x sums: non-negative and <= 2^31, so safe as uint32
+        __m128i sq = _mm_madd_epi16(x, x);
+        energy = _mm_add_epi64(energy, _mm_unpacklo_epi32(sq, zero));
+        energy = _mm_add_epi64(energy, _mm_unpackhi_epi32(sq, zero));
+
+        // Sign differs -> top bit of (x ^ p) set -> -1 after arithmetic shift
+        crossings = _mm_sub_epi16(crossings, _mm_srai_epi16(_mm_xor_si128(x, p), 15));
+    }
+
+    uint64_t e[2];
+    int16_t c[8];
+    _mm_storeu_si128((__m128i*)e, energy);
+    _mm_storeu_si128((__m128i*)c, crossings);
+
+    FrameFeatures f = head;
+    f.energy += e[0] + e[1];
+    for (int k = 0; k < 8; k++) f.zero_crossings += (uint16_t)c[k];
+
+    if (i < n) {
+        FrameFeatures tail = frame_features_scalar(frame + i, n - i, frame[i - 1]);
+        f.energy += tail.energy;
+        f.zero_crossings += tail.zero_crossings;
+    }
+    return f;
+}
+#elif defined(__ARM_NEON)
+inline FrameFeatures frame_features(const int16_t* frame, size_t n, int16_t prev) {
+    uint64x2_t energy = vdupq_n_u64(0);
+    int16x8_t crossings = vdupq_n_s16(0);
+
+    FrameFeatures head = frame_features_scalar(frame, n < 1 ? n : 1, prev);
+    size_t i = n < 1 ? n : 1;
+
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t x = vld1q_s16(frame + i);
+        int16x8_t p = vld1q_s16(frame + i - 1);
+
+        int32x4_t sq_lo = vmull_s16(vget_low_s16(x), vget_low_s16(x));
+        int32x4_t sq_hi = vmull_s16(vget_high_s16(x), vget_high_s16(x));
+        energy = vpadalq_u32(energy, vreinterpretq_u32_s32(sq_lo));
+        energy = vpadalq_u32(energy, vreinterpretq_u32_s32(sq_hi));
+
+        crossings = vsubq_s16(crossings, vshrq_n_s16(veorq_s16(x, p), 15));
+    }
+
+    FrameFeatures f = head;
+    f.energy += vgetq_lane_u64(energy, 0) + vgetq_lane_u64(energy, 1);
+    int16_t c[8];
+    vst1q_s16(c, crossings);
+    for (int k = 0; k < 8; k++) f.zero_crossings += (uint16_t)c[k];
+
+    if (i < n) {
+        FrameFeatures tail = frame_features_scalar(frame + i, n - i, frame[i - 1]);
+        f.energy += tail.energy;
+        f.zero_crossings += tail.zero_crossings;
+    }
+    return f;
+}
+#else
+inline FrameFeatures frame_features(const int16_t* frame, size_t n, int16_t prev) {
+    return frame_features_scalar(frame, n, prev);
+}
+#endif
+
+// --- VOICE ACTIVITY GATE ---
+// Frame-level energy + zero-crossing VAD in front of the recognizer.
+// A frame is speech when its RMS is above rms_threshold, or above half of
+// it with a high zero-crossing rate (unvoiced consonants like "s", "ş").
+// The gate stays open for hangover_frames after the last speech frame and
+// replays preroll_frames of audio from before the first speech frame.
+struct VadConfig {
+    size_t frame_size = 160;        // Samples per VAD frame (10 ms at 16 kHz)
+    double rms_threshold = 655.0;   // int16 RMS, same as NOISE_THRESHOLD 0.02 in voice_control.py
+    double zcr_threshold = 0.25;    // Crossings per sample for the fricative rule
+    size_t hangover_frames = 50;    // 500 ms: leaves Vosk enough trailing silence to endpoint
+    size_t preroll_frames = 20;     // 200 ms of context before speech onset
+};
+
+struct VadStats {
+    uint64_t frames_gated = 0;   // Frames not passed to the decoder
+    uint64_t frames_decoded = 0; // Frames passed to the decoder (speech, hangover, pre-roll)
+};
+
+class VoiceActivityGate {
+public:
+    explicit VoiceActivityGate(const VadConfig& config)
+        : config_(config),
+          preroll_(config.preroll_frames * config.frame_size),
+          pending_(config.frame_size) {}
+
+    const VadStats& stats() const { return stats_; }
+    bool is_open() const { return open_; }
+
+    // Forgets the current speech region and pre-roll (new audio source);
+    // stats keep accumulating
+    void reset() {
+        open_ = false;
+        hangover_left_ = 0;
+        last_sample_ = 0;
+        preroll_next_ = 0;
+        preroll_count_ = 0;
+        pending_count_ = 0;
+    }
+
+    // Classifies samples frame by frame and appends what the decoder should
+    // see to out. Returns true if the gate closed during this call (end of a
+    // speech region), so the caller can flush the recognizer.
+    bool process(const int16_t* samples, size_t count, std::vector<int16_t>& out) {
+        bool closed = false;
+        size_t i = 0;
+
+        // Complete a frame left over from the previous call
+        if (pending_count_ > 0) {
+            while (pending_count_ < config_.frame_size && i < count) pending_[pending_count_++] = samples[i++];
+            if (pending_count_ < config_.frame_size) return false;
+            closed |= process_frame(pending_.data(), out);
+            pending_count_ = 0;
+        }
+
+        for (; i + config_.frame_size <= count; i += config_.frame_size) {
+            closed |= process_frame(samples + i, out);
+        }
+
+        while (i < count) pending_[pending_count_++] = samples[i++];
+        return closed;
+    }
+
+private:
+    bool is_speech(const int16_t* frame) {
+        FrameFeatures f = frame_features(frame, config_.frame_size, last_sample_);
+        last_sample_ = frame[config_.frame_size - 1];
+
+        double rms = std::sqrt((double)f.energy / config_.frame_size);
+        double zcr = (double)f.zero_crossings / config_.frame_size;
+        return rms >= config_.rms_threshold ||
+               (rms >= config_.rms_threshold / 2 && zcr >= config_.zcr_threshold);
+    }
+
+    bool process_frame(const int16_t* frame, std::vector<int16_t>& out) {
+        if (is_speech(frame)) {
+            if (!open_) {
+                // Speech onset: replay the buffered context first
+                size_t frames = preroll_count_;
+                for (size_t k = 0; k < frames; k++) {
+                    size_t slot = (preroll_next_ + config_.preroll_frames - frames + k) % config_.preroll_frames;
+                    const int16_t* f = &preroll_[slot * config_.frame_size];
+                    out.insert(out.end(), f, f + config_.frame_size);
+                }
+                stats_.frames_decoded += frames;
+                stats_.frames_gated -= frames;
+                preroll_count_ = 0;
+                open_ = true;
+            }
+            hangover_left_ = config_.hangover_frames;
+        } else if (open_) {
+            if (hangover_left_ == 0) {
+                open_ = false;
+                remember(frame);
+                stats_.frames_gated++;
+                return true;
+            }
+            hangover_left_--;
+        }
+
+        if (open_) {
+            out.insert(out.end(), frame, frame + config_.frame_size);
+            stats_.frames_decoded++;
+        } else {
+            remember(frame);
+            stats_.frames_gated++;
+        }
+        return false;
+    }
+
+    // Keeps the most recent silent frames for pre-roll
+    void remember(const int16_t* frame) {
+        if (config_.preroll_frames == 0) return;
+        std::copy(frame, frame + config_.frame_size, &preroll_[preroll_next_ * config_.frame_size]);
+        preroll_next_ = (preroll_next_ + 1) % config_.preroll_frames;
+        if (preroll_count_ < config_.preroll_frames) preroll_count_++;
+    }
+
+    VadConfig config_;
+    VadStats stats_;
+    bool open_ = false;
+    size_t hangover_left_ = 0;
+    int16_t last_sample_ = 0;
+
+    std::vector<int16_t> preroll_; // preroll_frames x frame_size ring
+    size_t preroll_next_ = 0;
+    size_t preroll_count_ = 0;
+
+    std::vector<int16_t> pending_; // Partial frame carried between calls
+    size_t pending_count_ = 0;
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include "command_matcher.h"
+
+// --- VOSK RESULT PARSER ---
+// Single-pass, SAX-style reader for the JSON that vosk_recognizer_result(),
+// _final_result() and _partial_result() return:
+//
+//   { "result" : [ { "conf" : 0.98, "end" : 1.02, "start" : 0.6, "word" : "dur" }, ... ],
+//     "spk" : [ -0.12, ... ], "spk_frames" : 212, "text" : "dur" }
+//   { "alternatives" : [ { "confidence" : 231.4, "result" : [ ... ], "text" : "dur" }, ... ] }
+//   { "partial" : "du" }
+//
+// Nothing is copied or allocated: strings are handed to the handler as views
+// into the recognizer's buffer (valid until the next Vosk call on that
+// recognizer), with escapes left as-is. Unknown keys are skipped.
+//
+// The handler derives from VoskResultVisitor and overrides what it needs;
+// parse_vosk_result is a template, so the calls are static and inline. The
+// "spk" array (128 numbers) is only parsed for handlers that set wants_spk.
+struct VoskWord {
+    std::string_view word;
+    float conf = -1.0f; // -1: not reported (alternatives carry no per-word conf)
+    float start = 0.0f; // Seconds from the start of the utterance
+    float end = 0.0f;
+};
+
+struct VoskResultVisitor {
+    static constexpr bool wants_spk = false;
+
+    void on_text(std::string_view) {}
+    void on_partial(std::string_view) {}
+    void on_word(const VoskWord&) {}                                  // "result" / "partial_result"
+    void on_alternative_word(size_t /*alternative*/, const VoskWord&) {}
+    // After the alternative's words; alternatives come best first
+    void on_alternative(size_t /*alternative*/, float /*confidence*/, std::string_view /*text*/) {}
+    void on_spk_value(float) {}
+    void on_spk_frames(int) {}
+};
+
+namespace vosk_result_detail {
+
+inline const char* skip_ws(const char* p) {
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') p++;
+    return p;
+}
+
+// p at the opening quote; returns the contents, p after the closing quote
+inline const char* read_string(const char* p, std::string_view& out) {
+    if (*p != '"') return nullptr;
+    const char* start = ++p;
+    while (*p != '"') {
+        if (*p == '\0') return nullptr;
+        p += (*p == '\\' && p[1] != '\0') ? 2 : 1;
+    }
+    out = std::string_view(start, (size_t)(p - start));
+    return p + 1;
+}
+
+// Vosk prints plain decimals ("0.981634", "-0.1", "212"); those are parsed
+// here directly, which is several times faster than strtof. Anything else
+// (exponents, overlong mantissas) goes to strtof.
+inline const char* read_number(const char* p, float& out) {
+    static constexpr double kInversePow10[] = {1, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9};
+    const char* q = p;
+    bool negative = *q == '-';
+    if (negative) q++;
+    uint64_t mantissa = 0;
+    int digits = 0, decimals = 0;
+    for (; *q >= '0' && *q <= '9'; q++, digits++) mantissa = mantissa * 10 + (uint64_t)(*q - '0');
+    if (*q == '.') {
+        for (q++; *q >= '0' && *q <= '9'; q++, digits++, decimals++) mantissa = mantissa * 10 + (uint64_t)(*q - '0');
+    }
+    if (digits == 0 || digits > 18 || decimals > 9 || *q == 'e' || *q == 'E') {
+        char* end = nullptr;
+        out = strtof(p, &end);
+        return end == p ? nullptr : end;
+    }
+    double value = (double)mantissa * kInversePow10[decimals];
+    out = (float)(negative ? -value : value);
+    return q;
+}
+
+// Skips any JSON value (nested containers included)
+inline const char* skip_value(const char* p) {
+    p = skip_ws(p);
+    if (*p == '"') {
+        std::string_view ignored;
+        return read_string(p, ignored);
+    }
+    if (*p == '{' || *p == '[') {
+        // Jump between structural characters (strpbrk is vectorized in libc),
+        // e.g. across a whole "spk" array in one call
+        int depth = 0;
+        do {
+            if (*p == '"') {
+                std::string_view ignored;
+                if ((p = read_string(p, ignored)) == nullptr) return nullptr;
+            } else {
+                depth += (*p == '{' || *p == '[') ? 1 : -1;
+                p++;
+            }
+            if (depth > 0 && (p = strpbrk(p, "\"{}[]")) == nullptr) return nullptr;
+        } while (depth > 0);
+        return p;
+    }
+    while (*p != ',' && *p != '}' && *p != ']' && *p != '\0') p++; // Number, true, false, null
+    return p;
+}
+
+// Iterates "key": value pairs of the object at p; on_member(key, p) must
+// return p after the value (or nullptr on error). Returns p after '}'.
+template <class OnMember>
+const char* read_object(const char* p, OnMember&& on_member) {
+    p = skip_ws(p);
+    if (*p != '{') return nullptr;
+    p = skip_ws(p + 1);
+    if (*p == '}') return p + 1;
+    while (true) {
+        std::string_view key;
+        if ((p = read_string(p, key)) == nullptr) return nullptr;
+        p = skip_ws(p);
+        if (*p != ':') return nullptr;
+        if ((p = on_member(key, skip_ws(p + 1))) == nullptr) return nullptr;
+        p = skip_ws(p);
+        if (*p == '}') return p + 1;
+        if (*p != ',') return nullptr;
+        p = skip_ws(p + 1);
+    }
+}
+
+// Calls on_element(p) for each array element; same contract as read_object
+template <class OnElement>
+const char* read_array(const char* p, OnElement&& on_element) {
+    p = skip_ws(p);
+    if (*p != '[') return nullptr;
+    p = skip_ws(p + 1);
+    if (*p == ']') return p + 1;
+    while (true) {
+        if ((p = on_element(skip_ws(p))) == nullptr) return nullptr;
+        p = skip_ws(p);
+        if (*p == ']') return p + 1;
+        if (*p != ',') return nullptr;
+        p++;
+    }
+}
+
+inline const char* read_word(const char* p, VoskWord& w) {
+    w = VoskWord();
+    return read_object(p, [&](std::string_view key, const char* v) -> const char* {
+        if (key == "word") return read_string(v, w.word);
+        if (key == "conf") return read_number(v, w.conf);
+        if (key == "start") return read_number(v, w.start);
+        if (key == "end") return read_number(v, w.end);
+        return skip_value(v);
+    });
+}
+
+} // namespace vosk_result_detail
+
+// Returns false if json is null or malformed; callbacks made before the
+// error have already happened.
+template <class Handler>
+bool parse_vosk_result(const char* json, Handler& handler) {
+    using namespace vosk_result_detail;
+    if (json == nullptr) return false;
+
+    const char* p = read_object(json, [&](std::string_view key, const char* v) -> const char* {
+        if (key == "text" || key == "partial") {
+            std::string_view text;
+            if ((v = read_string(v, text)) == nullptr) return nullptr;
+            if (key == "text") handler.on_text(text);
+            else handler.on_partial(text);
+            return v;
+        }
+        if (key == "result" || key == "partial_result") {
+            return read_array(v, [&](const char* e) -> const char* {
+                VoskWord w;
+                if ((e = read_word(e, w)) != nullptr) handler.on_word(w);
+                return e;
+            });
+        }
+        if (key == "alternatives") {
+            size_t index = 0;
+            return read_array(v, [&](const char* e) -> const char* {
+                float confidence = 0.0f;
+                std::string_view text;
+                e = read_object(e, [&](std::string_view akey, const char* av) -> const char* {
+                    if (akey == "confidence") return read_number(av, confidence);
+                    if (akey == "text") return read_string(av, text);
+                    if (akey == "result") {
+                        return read_array(av, [&](const char* we) -> const char* {
+                            VoskWord w;
+                            if ((we = read_word(we, w)) != nullptr) handler.on_alternative_word(index, w);
+                            return we;
+                        });
+                    }
+                    return skip_value(av);
+                });
+                if (e != nullptr) handler.on_alternative(index++, confidence, text);
+                return e;
+            });
+        }
+        if (key == "spk") {
+            if constexpr (!Handler::wants_spk) return skip_value(v);
+            return read_array(v, [&](const char* e) -> const char* {
+                float value;
+                if ((e = read_number(e, value)) != nullptr) handler.on_spk_value(value);
+                return e;
+            });
+        }
+        if (key == "spk_frames") {
+            float frames;
+            if ((v = read_number(v, frames)) != nullptr) handler.on_spk_frames((int)frames);
+            return v;
+        }
+        return skip_value(v);
+    });
+    return p != nullptr;
+}
+
+// --- COMMAND WORD FROM A RESULT ---
+// Picks the command the same way as match_command (lowest priority value
+// wins) but from the word list, so the chosen word's confidence and timing
+// come with it.
+struct CommandPick {
+    char command = 0;
+    VoskWord word;      // The matched word
+    size_t words = 0;   // Words considered
+
+    void add(const VoskWord& w) {
+        words++;
+        const CommandEntry* entry = lookup_command(w.word);
+        if (entry != nullptr && (command == 0 || entry->priority < priority_)) {
+            command = entry->command;
+            priority_ = entry->priority;
+            word = w;
+        }
+    }
+
+    // Results without a word list (vosk_recognizer_set_words off) match the text
+    void from_text(std::string_view text) {
+        CommandMatch match = match_command(text);
+        command = match.command;
+        word = VoskWord();
+        word.word = match.span;
+    }
+
+private:
+    int priority_ = 0;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "command_matcher.h"
+
+// Recorded test / field audio: 16 kHz mono 16-bit WAV files plus the text
+// expected in each, shared by the offline tools (replay_bench.cpp,
+// batch_transcribe.cpp).
+#ifndef WAV_SAMPLE_RATE
+#define WAV_SAMPLE_RATE 16000
+#endif
+
+// --- WAV READER ---
+// Accepts only what the live pipeline sees: PCM, 16-bit, mono, WAV_SAMPLE_RATE.
+inline uint32_t le32(const unsigned char* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+inline uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+inline bool read_wav(const std::string& path, std::vector<int16_t>& samples, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char riff[12];
+    if (!in.read((char*)riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    bool have_format = false;
+    unsigned char chunk[8];
+    while (in.read((char*)chunk, sizeof(chunk))) {
+        uint32_t size = le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[16];
+            if (size < sizeof(fmt) || !in.read((char*)fmt, sizeof(fmt))) break;
+            if (le16(fmt) != 1 || le16(fmt + 2) != 1 || le32(fmt + 4) != WAV_SAMPLE_RATE || le16(fmt + 14) != 16) {
+                error = "need PCM 16-bit mono " + std::to_string(WAV_SAMPLE_RATE) + " Hz";
+                return false;
+            }
+            have_format = true;
+            in.seekg(size - sizeof(fmt) + (size & 1), std::ios::cur);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) break;
+            samples.resize(size / 2);
+            in.read((char*)samples.data(), (std::streamsize)samples.size() * 2); // Host is little-endian
+            samples.resize((size_t)in.gcount() / 2);
+            return true;
+        } else {
+            in.seekg(size + (size & 1), std::ios::cur); // Chunks are word aligned
+        }
+    }
+    error = have_format ? "no data chunk" : "no fmt chunk";
+    return false;
+}
+
+// --- EXPECTED COMMANDS ---
+// Label file lines: "<file.wav> <spoken text>", '#' starts a comment line.
+inline std::map<std::string, std::string> load_labels(const std::string& path) {
+    std::map<std::string, std::string> labels;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string file, text;
+        fields >> file;
+        std::getline(fields >> std::ws, text);
+        labels[file] = text;
+    }
+    return labels;
+}
+
+inline std::string text_from_filename(const std::filesystem::path& path) {
+    std::string text = path.stem().string();
+    for (char& c : text) {
+        if (c == '_' || c == '-') c = ' ';
+        else if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    }
+    return text;
+}
+
+// Command expected in a file: from its label if there is one, else its name
+inline char expected_command(const std::string& path, const std::map<std::string, std::string>& labels) {
+    std::filesystem::path file(path);
+    auto label = labels.find(file.filename().string());
+    return match_command(label != labels.end() ? label->second : text_from_filename(file)).command;
+}
+
+// --- COMMAND ACCURACY ---
+// Compares the command sent for each file with the expected one (0 = the
+// file holds no command and nothing should be sent).
+struct CommandScore {
+    int correct = 0;
+    int wrong = 0;            // A different command was sent
+    int missed = 0;           // Command expected, nothing sent
+    int false_positives = 0;  // No command expected, one was sent
+    int correct_rejects = 0;
+
+    void add(char expected, char sent) {
+        if (expected == 0) {
+            (sent == 0 ? correct_rejects : false_positives)++;
+        } else if (sent == 0) {
+            missed++;
+        } else {
+            (sent == expected ? correct : wrong)++;
+        }
+    }
+
+    int positives() const { return correct + wrong + missed; }
+    double percent() const { return positives() ? 100.0 * correct / positives() : 0.0; }
+
+    void print(std::ostream& out) const {
+        out << "Accuracy: " << correct << "/" << positives() << " correct (" << std::fixed << std::setprecision(1)
+            << percent() << "%), wrong=" << wrong << " missed=" << missed << " false_positives=" << false_positives
+            << " correct_rejects=" << correct_rejects << std::endl;
+    }
+};
+
+inline std::string command_label(char command) {
+    return command ? std::string(1, command) : std::string("-");
+}
+
+// Sorted .wav files under dir (recursive, so session directories work)
+inline std::vector<std::string> list_wav_files(const std::string& dir, std::error_code& ec) {
+    std::vector<std::string> files;
+    for (std::filesystem::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string ext = it->path().extension().string();
+        if (it->is_regular_file() && (ext == ".wav" || ext == ".WAV")) files.push_back(it->path().string());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
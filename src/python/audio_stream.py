@@ -0,0 +1,227 @@
+"""
+Streaming Audio Module
+======================
+Continuous microphone capture for the voice control system.
+
+Instead of recording fixed windows, a sounddevice.InputStream callback
+writes into a ring buffer and a single long-lived Vosk recognizer is fed
+continuously. Vosk's endpoint detection decides where an utterance ends,
+so a command is handled as soon as it is spoken and speech is never split
+at a window edge.
+
+Capture (StreamingListener) and decoding (UtteranceDecoder) are separate, so
+the same listener can feed a local recognizer or the speech daemon.
+"""
+
+import json
+import threading
+from typing import Iterator, NamedTuple, Optional, Tuple
+
+import numpy as np
+import sounddevice as sd
+
+from pcm_buffer import pcm_to_float
+from speaker_db import SpeakerMatch
+
+
+class AudioRingBuffer:
+    """
+    Fixed-size ring buffer of audio samples (int16 by default).
+
+    Written from the audio callback thread, read by the processing thread.
+    If the reader falls behind, the oldest samples are overwritten and
+    counted as overruns.
+    """
+
+    def __init__(self, capacity: int, dtype=np.int16):
+        self._buffer = np.zeros(capacity, dtype=dtype)
+        self._capacity = capacity
+        self._written = 0  # Total samples written
+        self._read = 0     # Total samples read
+        self._cond = threading.Condition()
+        self.overruns = 0  # Samples lost because the reader was too slow
+
+    def write(self, samples: np.ndarray) -> None:
+        """Append samples (called from the audio callback)."""
+        n = len(samples)
+        if n > self._capacity:
+            samples = samples[-self._capacity:]
+            n = self._capacity
+        with self._cond:
+            start = self._written % self._capacity
+            first = min(n, self._capacity - start)
+            self._buffer[start:start + first] = samples[:first]
+            self._buffer[:n - first] = samples[first:]
+            self._written += n
+
+            lost = self._written - self._read - self._capacity
+            if lost > 0:
+                self.overruns += lost
+                self._read += lost
+            self._cond.notify()
+
+    def read_into(self, out: np.ndarray, timeout: float) -> bool:
+        """
+        Fill out with exactly len(out) samples.
+
+        Args:
+            out: Preallocated destination
+            timeout: Maximum time to wait in seconds
+
+        Returns:
+            False if not enough audio arrived in time
+        """
+        count = len(out)
+        with self._cond:
+            if not self._cond.wait_for(lambda: self._written - self._read >= count, timeout):
+                return False
+            start = self._read % self._capacity
+            first = min(count, self._capacity - start)
+            out[:first] = self._buffer[start:start + first]
+            out[first:] = self._buffer[:count - first]
+            self._read += count
+            return True
+
+
+class Utterance(NamedTuple):
+    """One utterance ended by Vosk endpoint detection."""
+    text: str
+    audio: np.ndarray  # float32 audio since the previous endpoint (converted once)
+    auth: Optional[SpeakerMatch]  # Incremental auth decision, if enabled
+
+
+class UtteranceDecoder:
+    """
+    One persistent KaldiRecognizer fed block by block.
+
+    If an authenticator (IncrementalAuthenticator) is given, every block is
+    also fed to it, so the speaker decision is ready at the endpoint.
+    """
+
+    def __init__(self, recognizer, authenticator=None):
+        # Imported here: it loads libvosk, which a speech daemon client never needs
+        from vosk_pcm import accept_pcm
+        self._accept_pcm = accept_pcm
+        self.recognizer = recognizer
+        self.authenticator = authenticator
+        self._block_float = np.zeros(0, dtype=np.float32)
+
+    def feed(self, block: np.ndarray) -> Optional[Tuple[str, Optional[SpeakerMatch]]]:
+        """
+        Decode one int16 block.
+
+        Returns:
+            None while the utterance continues; at an endpoint, the tuple
+            (recognized_text, speaker_match). speaker_match is None without an
+            authenticator or when nothing was recognized.
+        """
+        if self.authenticator is not None:
+            if len(self._block_float) != len(block):
+                self._block_float = np.zeros(len(block), dtype=np.float32)
+            self.authenticator.add_audio(pcm_to_float(block, out=self._block_float))
+
+        # Vosk reads the int16 block in place
+        if not self._accept_pcm(self.recognizer, block):
+            return None
+
+        # Endpoint: one complete utterance
+        text = json.loads(self.recognizer.Result()).get('text', '').strip()
+        auth = None
+        if self.authenticator is not None:
+            if text:
+                auth = self.authenticator.finish()
+            self.authenticator.reset()
+        return text, auth
+
+
+class StreamingListener:
+    """
+    Streams microphone audio into a decoder (UtteranceDecoder or anything
+    with the same feed() method) and yields each utterance when the decoder
+    reports an endpoint.
+
+    Usage:
+        decoder = UtteranceDecoder(KaldiRecognizer(model, 16000))
+        with StreamingListener(decoder, 16000, device=0) as listener:
+            for utterance in listener.utterances():
+                ...
+    """
+
+    def __init__(self, decoder, sample_rate: int, device: Optional[int] = None,
+                 block_ms: int = 100, ring_seconds: int = 10, max_utterance_seconds: int = 10):
+        self.decoder = decoder
+        self.sample_rate = sample_rate
+        self.device = device
+        self.block_size = sample_rate * block_ms // 1000
+        self.max_utterance_samples = sample_rate * max_utterance_seconds
+        self.ring = AudioRingBuffer(sample_rate * ring_seconds, dtype=np.int16)
+        self.status_errors = 0  # Callbacks reporting input overflow etc.
+        self._stream = None
+        self._running = False
+
+    def _callback(self, indata, frames, time_info, status) -> None:
+        if status:
+            self.status_errors += 1
+        self.ring.write(indata[:, 0])
+
+    def start(self) -> None:
+        """Open the input stream and start capturing."""
+        self._stream = sd.InputStream(samplerate=self.sample_rate,
+                                      channels=1,
+                                      dtype='int16',
+                                      blocksize=self.block_size,
+                                      device=self.device,
+                                      callback=self._callback)
+        self._stream.start()
+        self._running = True
+
+    def stop(self) -> None:
+        """Stop capturing and close the stream."""
+        self._running = False
+        if self._stream is not None:
+            self._stream.stop()
+            self._stream.close()
+            self._stream = None
+
+    def __enter__(self) -> "StreamingListener":
+        self.start()
+        return self
+
+    def __exit__(self, exc_type, exc, tb) -> None:
+        self.stop()
+
+    def utterances(self) -> Iterator[Utterance]:
+        """
+        Feed audio to the decoder and yield utterances.
+
+        Yields:
+            Utterance with the recognized text, the audio since the previous
+            endpoint (capped at max_utterance_seconds) and, if the decoder
+            authenticates, its SpeakerMatch.
+        """
+        # Preallocated: one block and the utterance so far
+        block = np.zeros(self.block_size, dtype=np.int16)
+        utterance = np.zeros(self.max_utterance_samples, dtype=np.int16)
+        samples = 0
+
+        while self._running:
+            if not self.ring.read_into(block, timeout=1.0):
+                continue
+
+            # Keep the most recent max_utterance_samples
+            if samples + len(block) > len(utterance):
+                keep = len(utterance) - len(block)
+                utterance[:keep] = utterance[samples - keep:samples]
+                samples = keep
+            utterance[samples:samples + len(block)] = block
+            samples += len(block)
+
+            endpoint = self.decoder.feed(block)
+            if endpoint is None:
+                continue
+
+            text, auth = endpoint
+            audio = pcm_to_float(utterance[:samples])
+            samples = 0
+            if text:
+                yield Utterance(text, audio, auth)
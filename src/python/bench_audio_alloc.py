@@ -0,0 +1,84 @@
+"""
+Audio Allocation Benchmark
+==========================
+Compares the memory allocated per utterance by the old float32 path
+(sd.rec -> RMS -> float-to-int16 -> bytes) with the int16 path in
+pcm_buffer.py. Uses synthetic audio, so no microphone or model is needed.
+
+Usage:
+    python bench_audio_alloc.py [--seconds 3] [--utterances 50]
+"""
+
+import argparse
+import time
+import tracemalloc
+
+import numpy as np
+
+from pcm_buffer import PcmBuffer
+from vosk_pcm import vosk_handles
+
+SAMPLE_RATE = 16000
+
+
+def old_path(synthetic: np.ndarray) -> int:
+    """float32 recording as in the original voice_control.py loop."""
+    recording = np.empty((len(synthetic), 1), dtype=np.float32)  # sd.rec allocates per call
+    recording[:, 0] = synthetic
+    recording = np.squeeze(recording)
+    rms = np.sqrt(np.mean(recording**2))
+    audio_bytes = (recording * 32767).astype(np.int16).tobytes()
+    return len(audio_bytes) if rms >= 0 else 0
+
+
+def new_path(synthetic: np.ndarray, buffer: PcmBuffer) -> int:
+    """int16 recording into a preallocated buffer."""
+    np.multiply(synthetic, np.float32(32767), out=buffer.pcm, casting='unsafe')  # sd.rec(out=...) writes in place
+    buffer.invalidate()
+    rms = buffer.rms()
+    _, ffi = vosk_handles()
+    if ffi is not None:
+        samples = ffi.from_buffer("short[]", buffer.pcm)  # What accept_pcm hands to Vosk
+    else:
+        samples = memoryview(buffer.pcm)
+    return len(samples) if rms >= 0 else 0
+
+
+def measure(name: str, run, utterances: int) -> None:
+    run()  # Warm up lazily allocated state
+    peaks = []
+    start = time.perf_counter()
+    tracemalloc.start()
+    for _ in range(utterances):
+        tracemalloc.reset_peak()
+        baseline, _ = tracemalloc.get_traced_memory()
+        run()
+        _, peak = tracemalloc.get_traced_memory()
+        peaks.append(peak - baseline)
+    tracemalloc.stop()
+    elapsed = (time.perf_counter() - start) / utterances
+
+    print(f"{name:<12} peak transient allocation: mean {np.mean(peaks) / 1024:8.1f} KiB, "
+          f"max {max(peaks) / 1024:8.1f} KiB, time {elapsed * 1000:.3f} ms/utterance")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-utterance audio allocation benchmark")
+    parser.add_argument("--seconds", type=float, default=3.0, help="Utterance length")
+    parser.add_argument("--utterances", type=int, default=50, help="Utterances to measure")
+    args = parser.parse_args()
+
+    samples = int(args.seconds * SAMPLE_RATE)
+    t = np.arange(samples, dtype=np.float32) / SAMPLE_RATE
+    synthetic = (0.1 * np.sin(2 * np.pi * 220 * t)).astype(np.float32)
+    buffer = PcmBuffer(samples)
+
+    zero_copy = vosk_handles()[1] is not None
+    print(f"{args.utterances} utterances of {args.seconds:.1f} s "
+          f"({samples} samples, zero-copy Vosk input: {'yes' if zero_copy else 'no vosk, memoryview'})")
+    measure("float32 path", lambda: old_path(synthetic), args.utterances)
+    measure("int16 path", lambda: new_path(synthetic, buffer), args.utterances)
+
+
+if __name__ == "__main__":
+    main()
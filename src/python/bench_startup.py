@@ -0,0 +1,79 @@
+"""
+Startup Benchmark
+=================
+Time until a fresh control process is ready to recognize speech:
+
+- local:  import Vosk + Resemblyzer and load the model and the encoder
+          (what voice_control.py does without the daemon)
+- daemon: import the client and ping a running speech_daemon.py
+
+Each run is a new Python process, as after a crash/restart. The first
+local run may include reading the model from storage; later runs hit the
+page cache unless it is dropped between runs.
+
+Usage:
+    python speech_daemon.py &          # for the daemon measurement
+    python bench_startup.py [--runs 5]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+from speech_client import DEFAULT_SOCKET
+
+PROJECT_ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+MODEL_PATH = os.path.join(PROJECT_ROOT, "model")
+
+LOCAL_STARTUP = """
+from vosk import Model, SetLogLevel
+from resemblyzer import VoiceEncoder
+SetLogLevel(-1)
+Model({model!r})
+VoiceEncoder(verbose=False)
+"""
+
+DAEMON_STARTUP = """
+from speech_client import SpeechClient
+SpeechClient({socket!r}).ping()
+"""
+
+
+def time_process(code: str) -> float:
+    """Wall time of a new interpreter running code; raises if it fails."""
+    start = time.perf_counter()
+    subprocess.run([sys.executable, "-c", code], check=True,
+                   cwd=os.path.dirname(os.path.abspath(__file__)),
+                   stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    return time.perf_counter() - start
+
+
+def report(name: str, code: str, runs: int) -> None:
+    try:
+        times = [time_process(code) for _ in range(runs)]
+    except subprocess.CalledProcessError as e:
+        print(f"{name:<7} failed: {e.stderr.decode().strip().splitlines()[-1]}")
+        return
+    print(f"{name:<7} first {times[0] * 1000:8.1f} ms   "
+          f"min {min(times) * 1000:8.1f} ms   mean {sum(times) / len(times) * 1000:8.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Control process startup benchmark")
+    parser.add_argument("--runs", type=int, default=5, help="Processes started per mode")
+    parser.add_argument("--model", default=MODEL_PATH, help="Vosk model directory")
+    parser.add_argument("--socket", default=DEFAULT_SOCKET, help="Speech daemon socket")
+    args = parser.parse_args()
+
+    print(f"{args.runs} process starts per mode")
+    report("local", LOCAL_STARTUP.format(model=args.model), args.runs)
+    if os.path.exists(args.socket):
+        report("daemon", DAEMON_STARTUP.format(socket=args.socket), args.runs)
+    else:
+        print(f"daemon  skipped: no socket at {args.socket} (start speech_daemon.py)")
+
+
+if __name__ == "__main__":
+    main()
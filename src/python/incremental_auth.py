@@ -0,0 +1,109 @@
+"""
+Incremental Authentication Module
+=================================
+Speaker verification that runs while the user is still speaking.
+
+Resemblyzer's embed_utterance() splits an utterance into 1.6 s windows with
+50% overlap, embeds each window and averages the results. This module does
+the same on streaming audio: every time a full window has arrived it is
+embedded and added to a running mean, so by the end of speech the
+best-matching enrolled speaker is already known.
+"""
+
+import numpy as np
+from resemblyzer import VoiceEncoder
+from resemblyzer.audio import normalize_volume, wav_to_mel_spectrogram
+from resemblyzer.hparams import (audio_norm_target_dBFS, mel_window_step,
+                                 partials_n_frames, sampling_rate)
+
+from speaker_db import SpeakerDatabase, SpeakerMatch
+
+
+class IncrementalAuthenticator:
+    """
+    Running speaker similarity over sliding windows of voiced audio.
+
+    Usage:
+        auth = IncrementalAuthenticator(encoder, speakers)
+        for block in blocks:
+            auth.add_audio(block)
+        match = auth.finish()
+        auth.reset()
+    """
+
+    def __init__(self, encoder: VoiceEncoder, speakers: SpeakerDatabase,
+                 min_rms: float = 0.0, overlap: float = 0.5):
+        self.encoder = encoder
+        self.speakers = speakers
+        self.min_rms = min_rms  # Blocks quieter than this are not used for the embedding
+
+        # Window of partials_n_frames mel frames (1.6 s at 16 kHz)
+        self.window_samples = partials_n_frames * sampling_rate * mel_window_step // 1000
+        self.step_samples = max(int(self.window_samples * (1.0 - overlap)), 1)
+        # Voiced audio not yet embedded: _window[:_fill]. Preallocated so a
+        # block costs one copy and no allocation
+        self._window = np.zeros(self.window_samples, dtype=np.float32)
+
+        self.reset()
+
+    def reset(self) -> None:
+        """Forget the current utterance."""
+        self._fill = 0
+        self._embedding_sum = None
+        self.partials = 0
+
+    def add_audio(self, samples: np.ndarray) -> None:
+        """Append streaming audio; embeds every window that became complete."""
+        if len(samples) == 0:
+            return
+        if self.min_rms > 0.0 and np.sqrt(np.dot(samples, samples) / len(samples)) < self.min_rms:
+            return
+
+        offset = 0
+        while offset < len(samples):
+            count = min(len(samples) - offset, self.window_samples - self._fill)
+            self._window[self._fill:self._fill + count] = samples[offset:offset + count]
+            self._fill += count
+            offset += count
+
+            if self._fill == self.window_samples:
+                self._add_partial(self._window)
+                # Keep the overlap; slide it to the front
+                kept = self.window_samples - self.step_samples
+                self._window[:kept] = self._window[self.step_samples:]
+                self._fill = kept
+
+    def match(self) -> SpeakerMatch:
+        """Best enrolled speaker for the running mean embedding."""
+        if self._embedding_sum is None:
+            return SpeakerMatch(None, 0.0, False)
+        return self.speakers.best(self._embedding_sum.astype(np.float32))
+
+    def finish(self) -> SpeakerMatch:
+        """
+        Authentication decision for the utterance so far.
+
+        An utterance shorter than one window has no partial yet; its voiced
+        audio is embedded once, zero-padded to the window length.
+
+        Returns:
+            SpeakerMatch of the best enrolled speaker
+        """
+        if self._embedding_sum is None and self._fill > 0:
+            self._window[self._fill:] = 0.0
+            self._add_partial(self._window)
+
+        return self.match()
+
+    def _add_partial(self, window: np.ndarray) -> None:
+        wav = normalize_volume(window, audio_norm_target_dBFS, increase_only=True)
+        mel = wav_to_mel_spectrogram(wav)[:partials_n_frames]
+        if len(mel) < partials_n_frames:
+            mel = np.pad(mel, ((0, partials_n_frames - len(mel)), (0, 0)))
+
+        partial = self.encoder.embed_frames_batch(mel[np.newaxis])[0]
+        if self._embedding_sum is None:
+            self._embedding_sum = partial.astype(np.float64)
+        else:
+            self._embedding_sum += partial
+        self.partials += 1
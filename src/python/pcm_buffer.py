@@ -0,0 +1,58 @@
+"""
+PCM Buffer Module
+=================
+int16 audio path from the microphone to Vosk without per-utterance copies.
+
+Audio is captured once as int16 into preallocated buffers. Vosk reads that
+memory directly through its short-sample API (vosk_pcm.py), and a float32
+view for RMS and the voice embedder is produced into a reused scratch
+buffer only where it is needed.
+"""
+
+from typing import Optional
+
+import numpy as np
+
+INT16_SCALE = np.float32(1.0 / 32768.0)
+
+
+class PcmBuffer:
+    """
+    Preallocated int16 capture buffer with a reused float32 scratch view.
+
+    Usage:
+        buffer = PcmBuffer(3 * 16000)
+        sd.rec(out=buffer.frames, ...)
+        audio = buffer.to_float()
+    """
+
+    def __init__(self, samples: int):
+        # (samples, 1) so sounddevice can record into it directly
+        self.frames = np.zeros((samples, 1), dtype=np.int16)
+        self.pcm = self.frames[:, 0]  # 1-D view, shares memory
+        self._float = np.zeros(samples, dtype=np.float32)
+        self._float_valid = False
+
+    def invalidate(self) -> None:
+        """Call after new audio was written into frames."""
+        self._float_valid = False
+
+    def to_float(self) -> np.ndarray:
+        """float32 view in [-1, 1); converted once per recording into the scratch buffer."""
+        if not self._float_valid:
+            np.multiply(self.pcm, INT16_SCALE, out=self._float, casting='unsafe')
+            self._float_valid = True
+        return self._float
+
+    def rms(self) -> float:
+        """RMS on the float scale, without temporaries."""
+        audio = self.to_float()
+        return float(np.sqrt(np.dot(audio, audio) / len(audio)))
+
+
+def pcm_to_float(pcm: np.ndarray, out: Optional[np.ndarray] = None) -> np.ndarray:
+    """Convert int16 samples to float32 in [-1, 1), into out if given."""
+    if out is None:
+        out = np.empty(len(pcm), dtype=np.float32)
+    np.multiply(pcm, INT16_SCALE, out=out, casting='unsafe')
+    return out
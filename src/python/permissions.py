@@ -0,0 +1,131 @@
+"""
+Command Permissions Module
+==========================
+Which enrolled speaker may send which robot command.
+
+The table is a JSON file mapping speaker names to allowed command codes
+(the single-character UDP codes, "*" for all):
+
+    {
+        "default": ["0"],
+        "speakers": {
+            "alice": ["*"],
+            "guest": ["0", "H"]
+        }
+    }
+
+Speakers not listed get "default". The table is compiled into one bitmask
+per speaker, so a check is a dict lookup and an AND. The file is re-read
+when its modification time changes (checked at most once per second), so
+permissions can be edited without restarting the models.
+
+Without the file every speaker may send every command, as before
+permissions existed. A file that exists but cannot be read or parsed fails
+closed: if no table has loaded from it, every speaker may send only the
+fallback commands (stop); otherwise the last table that loaded stays.
+
+    >>> CommandPermissions("/nonexistent/permissions.json", "KOI0H").allowed("owner", "I")
+    Permissions: '/nonexistent/permissions.json' not found, all commands are allowed
+    True
+"""
+
+import json
+import os
+import time
+from typing import Dict, Iterable, Optional
+
+RELOAD_CHECK_INTERVAL = 1.0  # Seconds between modification time checks
+
+
+class CommandPermissions:
+    """
+    Hot-reloadable speaker -> allowed commands table.
+
+    Usage:
+        permissions = CommandPermissions("permissions.json", "KOI0H")
+        if permissions.allowed("guest", 'I'):
+            ...
+    """
+
+    def __init__(self, filepath: str, commands: Iterable[str],
+                 fallback: Iterable[str] = "0"):
+        """
+        Args:
+            filepath: Permissions JSON file
+            commands: Every command code that can be checked
+            fallback: Codes everyone may send without a valid table (stop)
+        """
+        self.filepath = filepath
+        # One bit per command code
+        self._bits: Dict[str, int] = {}
+        for command in commands:
+            self._bits.setdefault(command, 1 << len(self._bits))
+        self._all = (1 << len(self._bits)) - 1
+
+        # (per-speaker masks, default mask)
+        self._open = ({}, self._all)                    # No file
+        self._fallback = ({}, self._compile(fallback))  # Bad file, nothing loaded
+        self._table = self._open
+        self._loaded = False  # True while _table came from the file
+        self._mtime: Optional[float] = None
+        self._next_check = 0.0
+        self.reloads = 0
+
+        self._check_reload(force=True)
+
+    def allowed(self, speaker: Optional[str], command: str) -> bool:
+        """True if speaker may send command."""
+        self._check_reload()
+        masks, default = self._table
+        mask = masks.get(speaker, default)
+        return bool(mask & self._bits.get(command, 0))
+
+    def _compile(self, codes: Iterable[str]) -> int:
+        mask = 0
+        for code in codes:
+            if code == "*":
+                return self._all
+            if code not in self._bits:
+                print(f"Permissions: unknown command code '{code}' ignored")
+                continue
+            mask |= self._bits[code]
+        return mask
+
+    def _check_reload(self, force: bool = False) -> None:
+        now = time.monotonic()
+        if not force and now < self._next_check:
+            return
+        self._next_check = now + RELOAD_CHECK_INTERVAL
+
+        try:
+            mtime = os.stat(self.filepath).st_mtime
+        except OSError:
+            mtime = None
+        if mtime == self._mtime and not force:
+            return
+        self._mtime = mtime
+
+        if mtime is None:
+            print(f"Permissions: '{self.filepath}' not found, all commands are allowed")
+            self._table = self._open
+            self._loaded = False
+            return
+
+        try:
+            with open(self.filepath, encoding="utf-8") as f:
+                table = json.load(f)
+            masks = {name: self._compile(codes)
+                     for name, codes in table.get("speakers", {}).items()}
+            default = self._compile(table.get("default", []))
+        except (OSError, ValueError, AttributeError, TypeError) as e:
+            # Keep the last table that loaded, else only the fallback commands
+            print(f"Permissions: could not load '{self.filepath}': {e}")
+            if not self._loaded:
+                self._table = self._fallback
+            return
+
+        # Swapped in one assignment; readers never see a half-built table
+        self._table = (masks, default)
+        self._loaded = True
+        self.reloads += 1
+        print(f"Permissions: loaded {len(masks)} speakers from '{self.filepath}'")
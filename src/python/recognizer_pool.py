@@ -0,0 +1,99 @@
+"""
+Recognizer Pool Module
+======================
+Keeps warm Vosk recognizers so a command does not pay recognizer setup
+(decoder, feature pipeline, i-vector extractor state) on every recording.
+
+Recognizers are reset between utterances instead of being rebuilt. Each
+utterance is closed with FinalResult(), which flushes the audio still held
+in the feature pipeline so none of it leaks into the next utterance. Vosk
+rebuilds the feature pipeline after a final result, so online CMVN and
+i-vector adaptation start over with every command.
+"""
+
+import json
+import queue
+import threading
+import time
+from contextlib import contextmanager
+from typing import Iterator, Optional
+
+import numpy as np
+from vosk import Model, KaldiRecognizer
+
+from vosk_pcm import accept_pcm
+
+
+class RecognizerPool:
+    """
+    Fixed set of KaldiRecognizers shared between threads.
+
+    Usage:
+        pool = RecognizerPool(model, 16000)
+        text = pool.recognize(pcm)
+    """
+
+    def __init__(self, model: Model, sample_rate: int, size: int = 1):
+        self.sample_rate = sample_rate
+        self._idle = queue.Queue()
+        self._lock = threading.Lock()
+
+        # Timing statistics (seconds)
+        self.cold_setup_time = 0.0  # Mean KaldiRecognizer construction time
+        self.acquire_time = 0.0     # Total time spent getting a warm recognizer
+        self.reset_time = 0.0       # Total time spent in Reset()
+        self.uses = 0
+
+        for _ in range(size):
+            start = time.perf_counter()
+            recognizer = KaldiRecognizer(model, sample_rate)
+            self.cold_setup_time += time.perf_counter() - start
+            self._idle.put(recognizer)
+        self.cold_setup_time /= max(size, 1)
+
+    @contextmanager
+    def acquire(self) -> Iterator[KaldiRecognizer]:
+        """Borrow a recognizer; it is reset and returned to the pool afterwards."""
+        start = time.perf_counter()
+        recognizer = self._idle.get()
+        waited = time.perf_counter() - start
+        try:
+            yield recognizer
+        finally:
+            start = time.perf_counter()
+            recognizer.Reset()
+            reset = time.perf_counter() - start
+            with self._lock:
+                self.acquire_time += waited
+                self.reset_time += reset
+                self.uses += 1
+            self._idle.put(recognizer)
+
+    def recognize(self, pcm: np.ndarray) -> Optional[str]:
+        """
+        Recognize one complete utterance of int16 samples (passed without copying).
+
+        Returns:
+            Recognized text or None if nothing was recognized
+        """
+        with self.acquire() as recognizer:
+            accept_pcm(recognizer, pcm)
+            result = recognizer.FinalResult()
+        text = json.loads(result).get('text', '').strip()
+        return text if text else None
+
+    def saved_ms_per_command(self) -> float:
+        """Setup time saved per command compared with a new recognizer each time."""
+        if self.uses == 0:
+            return 0.0
+        reuse_cost = (self.acquire_time + self.reset_time) / self.uses
+        return (self.cold_setup_time - reuse_cost) * 1000.0
+
+    def report(self) -> str:
+        """One-line summary of the timing statistics."""
+        reuse_ms = 0.0
+        if self.uses:
+            reuse_ms = (self.acquire_time + self.reset_time) / self.uses * 1000.0
+        return (f"Recognizer pool: {self.uses} commands, cold setup "
+                f"{self.cold_setup_time * 1000.0:.1f} ms, reuse {reuse_ms:.2f} ms, "
+                f"saved {self.saved_ms_per_command():.1f} ms/command")
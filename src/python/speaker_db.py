@@ -0,0 +1,167 @@
+"""
+Speaker Database Module
+=======================
+Enrollment store for robots shared by several operators.
+
+Every enrolled speaker has one or more voice embeddings. All embeddings are
+kept in one contiguous float32 matrix (rows L2-normalized and grouped by
+speaker), saved as .npy so it can be memory-mapped, plus a JSON index with
+the speaker names, their row ranges and per-speaker thresholds.
+
+Matching a query is one matrix-vector product over all rows (BLAS), a
+per-speaker max over the row groups and a top-k selection.
+
+Layout of a database directory:
+    embeddings.npy  float32 [rows, dim]
+    index.json      {"dim": 256, "speakers": [{"name", "threshold", "offset", "count"}]}
+"""
+
+import json
+import os
+from typing import Dict, List, NamedTuple, Optional
+
+import numpy as np
+
+EMBEDDINGS_FILE = "embeddings.npy"
+INDEX_FILE = "index.json"
+
+
+class SpeakerMatch(NamedTuple):
+    """Score of a query against one enrolled speaker."""
+    name: Optional[str]  # None if nobody is enrolled
+    score: float         # Best cosine similarity among the speaker's embeddings
+    accepted: bool       # score >= the speaker's threshold
+
+
+class SpeakerDatabase:
+    """
+    Many speakers, several embeddings each, matched in one product.
+
+    Usage:
+        db = SpeakerDatabase.load("speaker_db")
+        best = db.best(embedding)
+        if best.accepted:
+            ...
+    """
+
+    def __init__(self, dim: int = 256, default_threshold: float = 0.75):
+        self.dim = dim
+        self.default_threshold = default_threshold
+        self.names: List[str] = []
+        self.thresholds = np.zeros(0, dtype=np.float32)
+        self.offsets = np.zeros(0, dtype=np.int64)  # First row of each speaker
+        self.counts = np.zeros(0, dtype=np.int64)
+        self.matrix = np.zeros((0, dim), dtype=np.float32)
+
+    # ---------- Loading and saving ----------
+
+    @classmethod
+    def load(cls, directory: str, mmap: bool = True) -> "SpeakerDatabase":
+        """Load a database; the embedding matrix is memory-mapped read-only by default."""
+        with open(os.path.join(directory, INDEX_FILE)) as f:
+            index = json.load(f)
+
+        db = cls(dim=index["dim"])
+        speakers = index["speakers"]
+        db.names = [s["name"] for s in speakers]
+        db.thresholds = np.array([s["threshold"] for s in speakers], dtype=np.float32)
+        db.offsets = np.array([s["offset"] for s in speakers], dtype=np.int64)
+        db.counts = np.array([s["count"] for s in speakers], dtype=np.int64)
+        db.matrix = np.load(os.path.join(directory, EMBEDDINGS_FILE),
+                            mmap_mode='r' if mmap else None)
+        if db.matrix.dtype != np.float32 or db.matrix.shape[1] != db.dim:
+            raise ValueError(f"'{directory}': embeddings must be float32 [rows, {db.dim}]")
+        return db
+
+    @classmethod
+    def from_signature(cls, signature: np.ndarray, threshold: float,
+                       name: str = "owner") -> "SpeakerDatabase":
+        """Single-speaker database from a legacy owner_voice_signature.npy vector."""
+        db = cls(dim=len(signature), default_threshold=threshold)
+        db.add(name, signature[np.newaxis], threshold)
+        return db
+
+    def save(self, directory: str) -> None:
+        """Write the matrix and the index (the matrix file is replaced atomically)."""
+        os.makedirs(directory, exist_ok=True)
+        tmp = os.path.join(directory, EMBEDDINGS_FILE + ".tmp")
+        with open(tmp, "wb") as f:
+            np.save(f, np.ascontiguousarray(self.matrix, dtype=np.float32))
+        os.replace(tmp, os.path.join(directory, EMBEDDINGS_FILE))
+
+        index = {
+            "dim": self.dim,
+            "speakers": [
+                {"name": name, "threshold": float(self.thresholds[i]),
+                 "offset": int(self.offsets[i]), "count": int(self.counts[i])}
+                for i, name in enumerate(self.names)
+            ],
+        }
+        with open(os.path.join(directory, INDEX_FILE), "w") as f:
+            json.dump(index, f, indent=2)
+
+    # ---------- Enrollment ----------
+
+    def add(self, name: str, embeddings: np.ndarray, threshold: Optional[float] = None) -> None:
+        """
+        Add embeddings for a speaker (new or existing). Rows stay grouped by
+        speaker, so the matrix is rebuilt; enrollment is rare, matching is not.
+
+        Args:
+            name: Speaker name
+            embeddings: [n, dim] embeddings (normalized here)
+            threshold: Acceptance threshold; keeps the existing one if None
+        """
+        embeddings = np.atleast_2d(np.asarray(embeddings, dtype=np.float32))
+        if embeddings.shape[1] != self.dim:
+            raise ValueError(f"Embedding size {embeddings.shape[1]} != database size {self.dim}")
+        embeddings = embeddings / np.linalg.norm(embeddings, axis=1, keepdims=True)
+
+        groups: Dict[str, np.ndarray] = {n: self.embeddings_of(n) for n in self.names}
+        thresholds = dict(zip(self.names, self.thresholds.tolist()))
+        if name in groups:
+            groups[name] = np.concatenate((groups[name], embeddings))
+        else:
+            groups[name] = embeddings
+            self.names.append(name)
+        if threshold is not None or name not in thresholds:
+            thresholds[name] = self.default_threshold if threshold is None else threshold
+
+        self.counts = np.array([len(groups[n]) for n in self.names], dtype=np.int64)
+        self.offsets = np.concatenate(([0], np.cumsum(self.counts)[:-1])).astype(np.int64)
+        self.thresholds = np.array([thresholds[n] for n in self.names], dtype=np.float32)
+        self.matrix = np.ascontiguousarray(np.concatenate([groups[n] for n in self.names]))
+
+    def embeddings_of(self, name: str) -> np.ndarray:
+        i = self.names.index(name)
+        return np.array(self.matrix[self.offsets[i]:self.offsets[i] + self.counts[i]])
+
+    def __len__(self) -> int:
+        return len(self.names)
+
+    # ---------- Matching ----------
+
+    def scores(self, query: np.ndarray) -> np.ndarray:
+        """Best similarity per speaker, one value per entry of self.names."""
+        query = np.asarray(query, dtype=np.float32)
+        norm = np.linalg.norm(query)
+        if len(self.names) == 0 or norm == 0.0:
+            return np.zeros(len(self.names), dtype=np.float32)
+        row_scores = self.matrix @ (query / norm)  # One sgemv over every enrolled embedding
+        return np.maximum.reduceat(row_scores, self.offsets)
+
+    def top_k(self, query: np.ndarray, k: int = 1) -> List[SpeakerMatch]:
+        """The k best-scoring speakers, best first."""
+        scores = self.scores(query)
+        k = min(k, len(scores))
+        if k == 0:
+            return []
+        best = np.argpartition(-scores, k - 1)[:k]
+        best = best[np.argsort(-scores[best])]
+        return [SpeakerMatch(self.names[i], float(scores[i]), bool(scores[i] >= self.thresholds[i]))
+                for i in best]
+
+    def best(self, query: np.ndarray) -> SpeakerMatch:
+        """Best-scoring speaker (accepted only if above its own threshold)."""
+        matches = self.top_k(query, 1)
+        return matches[0] if matches else SpeakerMatch(None, 0.0, False)
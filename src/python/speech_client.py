@@ -0,0 +1,146 @@
+"""
+Speech Daemon Client
+====================
+Client side of the speech daemon (speech_daemon.py) and the wire protocol
+both sides share.
+
+The client only needs numpy and the standard library, so a control process
+that talks to the daemon starts in milliseconds: it never imports Vosk,
+Resemblyzer or torch, and never loads a model.
+
+Protocol (Unix stream socket), one frame per request and per reply:
+    uint32 header_length, uint32 payload_length  (network byte order)
+    header   JSON object, e.g. {"op": "analyze"}, at most MAX_HEADER_BYTES
+    payload  int16 little-endian PCM for audio requests, empty otherwise,
+             at most MAX_PAYLOAD_BYTES
+"""
+
+import json
+import socket
+import struct
+from typing import Optional, Tuple
+
+import numpy as np
+
+from speaker_db import SpeakerMatch
+
+DEFAULT_SOCKET = "/tmp/robot_speech/speech.sock"  # The daemon keeps the directory 0700
+
+MAX_HEADER_BYTES = 64 * 1024
+MAX_PAYLOAD_BYTES = 60 * 16000 * 2  # 60 s of 16 kHz int16 audio
+
+_FRAME = struct.Struct("!II")
+
+
+class SpeechDaemonError(Exception):
+    """The daemon answered a request with an error."""
+
+
+# ---------- Framing ----------
+
+def _recv_exact(sock: socket.socket, count: int) -> bytes:
+    data = bytearray(count)
+    view = memoryview(data)
+    received = 0
+    while received < count:
+        n = sock.recv_into(view[received:])
+        if n == 0:
+            raise ConnectionError("speech daemon connection closed")
+        received += n
+    return bytes(data)
+
+
+def send_message(sock: socket.socket, header: dict, payload=b"") -> None:
+    """Send one frame; payload may be bytes or a contiguous numpy array."""
+    head = json.dumps(header).encode()
+    body = memoryview(payload).cast("B") if len(payload) else b""
+    sock.sendall(_FRAME.pack(len(head), len(body)) + head)
+    if len(body):
+        sock.sendall(body)
+
+
+def recv_message(sock: socket.socket) -> Tuple[dict, bytes]:
+    """Receive one frame as (header, payload); ValueError if it is too large."""
+    head_len, body_len = _FRAME.unpack(_recv_exact(sock, _FRAME.size))
+    if head_len > MAX_HEADER_BYTES or body_len > MAX_PAYLOAD_BYTES:
+        raise ValueError(f"frame too large ({head_len} + {body_len} bytes)")
+    header = json.loads(_recv_exact(sock, head_len))
+    payload = _recv_exact(sock, body_len) if body_len else b""
+    return header, payload
+
+
+def match_from_reply(reply: dict) -> SpeakerMatch:
+    return SpeakerMatch(reply.get("speaker"), float(reply.get("score", 0.0)),
+                        bool(reply.get("accepted", False)))
+
+
+# ---------- Client ----------
+
+class SpeechClient:
+    """
+    Connection to a running speech daemon.
+
+    Usage:
+        client = SpeechClient()
+        match, text = client.analyze(pcm)
+    """
+
+    def __init__(self, path: str = DEFAULT_SOCKET, timeout: float = 30.0):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.settimeout(timeout)
+        self.sock.connect(path)
+
+    def close(self) -> None:
+        self.sock.close()
+
+    def request(self, op: str, pcm: Optional[np.ndarray] = None, **fields) -> dict:
+        header = dict(fields, op=op)
+        if pcm is not None:
+            pcm = np.ascontiguousarray(pcm, dtype="<i2")
+        send_message(self.sock, header, pcm if pcm is not None else b"")
+        reply, _ = recv_message(self.sock)
+        if "error" in reply:
+            raise SpeechDaemonError(reply["error"])
+        return reply
+
+    def ping(self) -> dict:
+        """Daemon status (uptime, loaded models)."""
+        return self.request("ping")
+
+    def recognize(self, pcm: np.ndarray) -> Optional[str]:
+        """Recognize one complete utterance of int16 samples."""
+        return self.request("recognize", pcm).get("text")
+
+    def authenticate(self, pcm: np.ndarray) -> SpeakerMatch:
+        """Match one utterance against the daemon's enrolled speakers."""
+        return match_from_reply(self.request("authenticate", pcm))
+
+    def analyze(self, pcm: np.ndarray) -> Tuple[SpeakerMatch, Optional[str]]:
+        """
+        Authentication and recognition in parallel inside the daemon.
+
+        Returns:
+            Tuple of (speaker_match, recognized_text); text is None unless
+            the speaker was accepted.
+        """
+        reply = self.request("analyze", pcm)
+        return match_from_reply(reply), reply.get("text")
+
+
+class RemoteDecoder:
+    """
+    UtteranceDecoder counterpart that decodes in the daemon: the daemon keeps
+    a recognizer and an incremental authenticator for this connection.
+    Plugs into audio_stream.StreamingListener.
+    """
+
+    def __init__(self, client: SpeechClient):
+        self.client = client
+        self.client.request("stream_start")
+
+    def feed(self, block: np.ndarray) -> Optional[Tuple[str, Optional[SpeakerMatch]]]:
+        reply = self.client.request("stream_audio", block)
+        if not reply.get("endpoint"):
+            return None
+        text = reply.get("text") or ""
+        return text, (match_from_reply(reply) if text else None)
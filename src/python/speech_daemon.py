@@ -0,0 +1,227 @@
+"""
+Speech Daemon
+=============
+Loads the Vosk model, the Resemblyzer encoder and the enrolled speakers
+once and keeps them resident, serving recognition and authentication to
+short-lived clients over a Unix socket (see speech_client.py).
+
+Restarting the control application then only costs a socket connect
+instead of reading the models from storage again.
+
+Usage:
+    python speech_daemon.py [--socket /tmp/robot_speech/speech.sock] [--workers 2]
+
+The socket's directory is created with mode 0700 (an existing one must be
+owned by the daemon's user and not accessible to anyone else), and the
+socket itself is created with mode 0600, so only the same user can connect.
+"""
+
+import argparse
+import os
+import signal
+import socket
+import socketserver
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+from resemblyzer import VoiceEncoder, preprocess_wav
+from vosk import Model, KaldiRecognizer
+
+from audio_stream import UtteranceDecoder
+from incremental_auth import IncrementalAuthenticator
+from pcm_buffer import pcm_to_float
+from recognizer_pool import RecognizerPool
+from speaker_db import SpeakerDatabase, SpeakerMatch
+from speech_client import DEFAULT_SOCKET, recv_message, send_message
+
+PROJECT_ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+# ==================== CONFIGURATION ====================
+MODEL_PATH = os.path.join(PROJECT_ROOT, "model")
+SIGNATURE_FILE = os.path.join(PROJECT_ROOT, "owner_voice_signature.npy")
+SPEAKER_DB_DIR = os.path.join(PROJECT_ROOT, "speaker_db")
+SIMILARITY_THRESHOLD = 0.75  # For the owner signature file
+SAMPLE_RATE = 16000
+NOISE_THRESHOLD = 0.02  # Streaming: quieter blocks are not used for authentication
+
+
+class SpeechEngine:
+    """Resident models shared by all client connections."""
+
+    def __init__(self, model_path: str, speakers: SpeakerDatabase, workers: int):
+        start = time.perf_counter()
+        self.model = Model(model_path)
+        self.encoder = VoiceEncoder()
+        self.speakers = speakers
+        self.recognizers = RecognizerPool(self.model, SAMPLE_RATE, size=workers)
+        self.executor = ThreadPoolExecutor(max_workers=2 * workers)
+        self.load_time = time.perf_counter() - start
+        self.started = time.time()
+
+    def authenticate(self, pcm: np.ndarray) -> SpeakerMatch:
+        try:
+            embedding = self.encoder.embed_utterance(preprocess_wav(pcm_to_float(pcm)))
+        except Exception:
+            return SpeakerMatch(None, 0.0, False)
+        return self.speakers.best(embedding)
+
+    def recognize(self, pcm: np.ndarray):
+        return self.recognizers.recognize(pcm)
+
+    def analyze(self, pcm: np.ndarray):
+        """Authentication and recognition in parallel; text only if accepted."""
+        auth_future = self.executor.submit(self.authenticate, pcm)
+        asr_future = self.executor.submit(self.recognize, pcm)
+        match = auth_future.result()
+        text = asr_future.result()
+        return match, (text if match.accepted else None)
+
+    def stream_decoder(self) -> UtteranceDecoder:
+        authenticator = IncrementalAuthenticator(self.encoder, self.speakers,
+                                                 min_rms=NOISE_THRESHOLD)
+        return UtteranceDecoder(KaldiRecognizer(self.model, SAMPLE_RATE), authenticator)
+
+
+def match_reply(match: SpeakerMatch) -> dict:
+    return {"speaker": match.name, "score": match.score, "accepted": match.accepted}
+
+
+class SpeechRequestHandler(socketserver.BaseRequestHandler):
+    """One client connection; requests are answered in order."""
+
+    def handle(self) -> None:
+        engine: SpeechEngine = self.server.engine
+        decoder = None  # Created by stream_start
+
+        while True:
+            try:
+                header, payload = recv_message(self.request)
+            except (ConnectionError, OSError, ValueError):
+                return
+
+            op = header.get("op")
+            pcm = np.frombuffer(payload, dtype="<i2")
+            try:
+                if op == "ping":
+                    reply = {"ok": True, "uptime": time.time() - engine.started,
+                             "load_time": engine.load_time, "speakers": len(engine.speakers)}
+                elif op == "recognize":
+                    reply = {"text": engine.recognize(pcm)}
+                elif op == "authenticate":
+                    reply = match_reply(engine.authenticate(pcm))
+                elif op == "analyze":
+                    match, text = engine.analyze(pcm)
+                    reply = dict(match_reply(match), text=text)
+                elif op == "stream_start":
+                    decoder = engine.stream_decoder()
+                    reply = {"ok": True}
+                elif op == "stream_audio":
+                    if decoder is None:
+                        raise ValueError("stream_audio before stream_start")
+                    endpoint = decoder.feed(pcm)
+                    reply = {"endpoint": endpoint is not None}
+                    if endpoint is not None:
+                        text, match = endpoint
+                        reply["text"] = text
+                        if match is not None:
+                            reply.update(match_reply(match))
+                else:
+                    raise ValueError(f"unknown op '{op}'")
+            except Exception as e:
+                reply = {"error": str(e)}
+
+            try:
+                send_message(self.request, reply)
+            except OSError:
+                return
+
+
+class SpeechServer(socketserver.ThreadingMixIn, socketserver.UnixStreamServer):
+    daemon_threads = True
+
+
+def load_speakers(db_dir: str, signature_file: str) -> SpeakerDatabase:
+    if os.path.exists(os.path.join(db_dir, "index.json")):
+        return SpeakerDatabase.load(db_dir)
+    if os.path.exists(signature_file):
+        return SpeakerDatabase.from_signature(np.load(signature_file), SIMILARITY_THRESHOLD)
+    print("WARNING: no enrolled speakers; every voice will be denied.")
+    return SpeakerDatabase()
+
+
+def prepare_socket_dir(path: str) -> None:
+    """Create the socket's directory as 0700, or check that an existing one is private."""
+    directory = os.path.dirname(os.path.abspath(path))
+    os.makedirs(directory, mode=0o700, exist_ok=True)
+    st = os.stat(directory)
+    if st.st_uid != os.getuid() or st.st_mode & 0o077:
+        raise PermissionError(f"'{directory}' must be owned by this user and have mode 0700")
+
+
+def remove_stale_socket(path: str) -> None:
+    """Unlink a socket left by a daemon that exited; refuse if one still answers on it."""
+    probe = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        probe.connect(path)
+    except FileNotFoundError:
+        return
+    except ConnectionRefusedError:
+        os.unlink(path)  # Nobody listening: stale
+        return
+    finally:
+        probe.close()
+    raise FileExistsError(f"another speech daemon is listening on '{path}'")
+
+
+def _terminate(signum, frame):
+    raise KeyboardInterrupt
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Resident speech recognition/authentication daemon")
+    parser.add_argument("--socket", default=DEFAULT_SOCKET, help="Unix socket path")
+    parser.add_argument("--model", default=MODEL_PATH, help="Vosk model directory")
+    parser.add_argument("--db", default=SPEAKER_DB_DIR, help="Speaker database directory")
+    parser.add_argument("--signature", default=SIGNATURE_FILE, help="Owner signature file")
+    parser.add_argument("--workers", type=int, default=2, help="Warm recognizers")
+    args = parser.parse_args()
+
+    print("Loading models...")
+    try:
+        engine = SpeechEngine(args.model, load_speakers(args.db, args.signature), args.workers)
+    except Exception as e:
+        print(f"Error loading models: {e}")
+        sys.exit(1)
+    print(f"Models loaded in {engine.load_time:.2f} s ({len(engine.speakers)} speakers)")
+
+    try:
+        prepare_socket_dir(args.socket)
+        remove_stale_socket(args.socket)
+    except OSError as e:
+        print(f"Error: {e}")
+        sys.exit(1)
+    # The socket gets its mode at bind; 0600 from the start, never wider
+    old_umask = os.umask(0o177)
+    try:
+        server = SpeechServer(args.socket, SpeechRequestHandler)
+    finally:
+        os.umask(old_umask)
+    server.engine = engine
+
+    signal.signal(signal.SIGTERM, _terminate)
+    print(f"Speech daemon listening on {args.socket}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+        os.unlink(args.socket)
+        engine.executor.shutdown(wait=False)
+        print("Speech daemon stopped.")
+
+
+if __name__ == "__main__":
+    main()
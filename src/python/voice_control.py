@@ -9,17 +9,35 @@ Features:
 - Speech recognition using Vosk (offline)
 - Noise filtering to reduce false positives
 - UDP command transmission to robot
+- Pipelined mode: authentication and recognition run in parallel
+- Streaming capture: commands end at speech endpoints, not fixed windows
+- Speech daemon mode: models stay loaded in speech_daemon.py across restarts
 """
 
+from __future__ import annotations
+
 import sounddevice as sd
-from resemblyzer import VoiceEncoder, preprocess_wav
-from vosk import Model, KaldiRecognizer
 import numpy as np
 import socket
 import json
 import sys
 import os
-from typing import Optional, Tuple
+import time
+from concurrent.futures import ThreadPoolExecutor
+from typing import TYPE_CHECKING, Optional, Tuple
+
+from audio_stream import StreamingListener, UtteranceDecoder
+from pcm_buffer import PcmBuffer
+from permissions import CommandPermissions
+from speaker_db import SpeakerDatabase, SpeakerMatch
+from speech_client import SpeechClient, SpeechDaemonError, RemoteDecoder
+
+# Resemblyzer (torch) and Vosk are imported only when the models are loaded
+# in this process, so a client of the speech daemon starts in milliseconds
+if TYPE_CHECKING:
+    from resemblyzer import VoiceEncoder
+    from vosk import Model
+    from recognizer_pool import RecognizerPool
 
 # Add parent directory to path for relative imports
 sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
@@ -32,13 +50,19 @@ ROBOT_IP = "192.168.1.120"
 ROBOT_PORT = 5001
 MODEL_PATH = os.path.join(PROJECT_ROOT, "model")
 SIGNATURE_FILE = os.path.join(PROJECT_ROOT, "owner_voice_signature.npy")
+SPEAKER_DB_DIR = os.path.join(PROJECT_ROOT, "speaker_db")  # Used instead of SIGNATURE_FILE if present
+PERMISSIONS_FILE = os.path.join(PROJECT_ROOT, "permissions.json")  # Speaker -> allowed commands (else all)
+
+# Speech daemon settings
+USE_SPEECH_DAEMON = False  # Use the models resident in speech_daemon.py instead of loading them
+SPEECH_DAEMON_SOCKET = "/tmp/robot_speech/speech.sock"
 
 # Audio device settings
 AUDIO_DEVICE_ID = 0  # Set to your microphone device ID (0 = default)
 
 # Security and sensitivity settings
-SIMILARITY_THRESHOLD = 0.75  # Voice authentication threshold
-RECORDING_DURATION = 3  # Recording duration in seconds
+SIMILARITY_THRESHOLD = 0.75  # Voice authentication threshold (owner signature file)
+RECORDING_DURATION = 3  # Recording duration in seconds (window mode)
 NOISE_THRESHOLD = 0.02  # RMS threshold for noise filtering
 # 0.01 = Very sensitive (captures whispers, may capture noise)
 # 0.05 = Medium (normal speech)
@@ -48,6 +72,20 @@ NOISE_THRESHOLD = 0.02  # RMS threshold for noise filtering
 # Audio settings
 SAMPLE_RATE = 16000
 
+# Capture settings
+CAPTURE_MODE = "stream"  # "stream": continuous capture, utterances end at Vosk endpoints
+                         # "window": fixed RECORDING_DURATION recordings
+STREAM_BLOCK_MS = 100  # Audio fed to the recognizer per step in stream mode
+MAX_UTTERANCE_SECONDS = 10  # Audio kept per utterance for authentication
+INCREMENTAL_AUTH = True  # Stream mode: embed 1.6 s windows while the user speaks,
+                         # so the auth decision is ready at the endpoint
+
+# Pipeline settings
+PIPELINED_MODE = True  # Window mode: run voice authentication and speech recognition in parallel
+# Both stages spend most of their time in native code (torch / Kaldi) that
+# releases the GIL, so two threads really run concurrently. The recognized
+# command is only sent after authentication succeeds.
+
 # Command mappings (Turkish to robot commands)
 COMMAND_MAPPINGS = {
     "kalk": 'K',      # Stand up
@@ -61,6 +99,10 @@ COMMAND_MAPPINGS = {
     "selam": 'H',     # Hello/Greeting
 }
 
+# Keywords in the order they are checked: stop first, so "ileri dur" stops
+STOP_COMMAND = '0'
+COMMAND_KEYWORDS = sorted(COMMAND_MAPPINGS.items(), key=lambda item: item[1] != STOP_COMMAND)
+
 
 def load_voice_signature(filepath: str) -> np.ndarray:
     """
@@ -113,57 +155,103 @@ def send_command(sock: socket.socket, command: str, robot_ip: str, robot_port: i
         print(f"Error sending command: {e}")
 
 
-def authenticate_voice(audio_data: np.ndarray, encoder: VoiceEncoder, 
-                      owner_signature: np.ndarray, threshold: float) -> Tuple[bool, float]:
+def load_speakers() -> SpeakerDatabase:
     """
-    Authenticate voice by comparing against owner signature.
+    Load the enrolled speakers: the multi-user database if it exists,
+    otherwise the single owner signature.
+    
+    Returns:
+        SpeakerDatabase
+    """
+    if os.path.exists(os.path.join(SPEAKER_DB_DIR, "index.json")):
+        speakers = SpeakerDatabase.load(SPEAKER_DB_DIR)
+        print(f"-> Speaker database: {len(speakers)} speakers, {len(speakers.matrix)} embeddings")
+        return speakers
+    return SpeakerDatabase.from_signature(load_voice_signature(SIGNATURE_FILE), SIMILARITY_THRESHOLD)
+
+
+def authenticate_voice(audio_data: np.ndarray, encoder: VoiceEncoder,
+                      speakers: SpeakerDatabase) -> SpeakerMatch:
+    """
+    Authenticate voice by matching it against the enrolled speakers.
     
     Args:
         audio_data: Raw audio data
         encoder: VoiceEncoder instance
-        owner_signature: Owner's voice signature
-        threshold: Similarity threshold
+        speakers: Enrolled speakers
         
     Returns:
-        Tuple of (is_authenticated, similarity_score)
+        SpeakerMatch of the best speaker (accepted if above its threshold)
     """
     try:
+        from resemblyzer import preprocess_wav
         processed_audio = preprocess_wav(audio_data)
     except Exception:
-        return False, 0.0
+        return SpeakerMatch(None, 0.0, False)
     
     try:
         current_signature = encoder.embed_utterance(processed_audio)
-        similarity = np.inner(owner_signature, current_signature)
-        return similarity >= threshold, similarity
+        return speakers.best(current_signature)
     except Exception:
-        return False, 0.0
+        return SpeakerMatch(None, 0.0, False)
+
 
+def print_identity(match: SpeakerMatch) -> None:
+    """Print the identity score and the matched speaker."""
+    if match.name is not None and match.name != "owner":
+        print(f"Identity Score: {match.score:.2f} ({match.name})")
+    else:
+        print(f"Identity Score: {match.score:.2f}")
 
-def recognize_speech(audio_data: np.ndarray, model: Model, sample_rate: int) -> Optional[str]:
+
+def recognize_speech(pcm: np.ndarray, recognizers: RecognizerPool) -> Optional[str]:
     """
     Recognize speech from audio using Vosk.
     
     Args:
-        audio_data: Raw audio data (float32, normalized)
-        model: Vosk model instance
-        sample_rate: Audio sample rate
+        pcm: Recorded audio as int16 samples (read in place by Vosk)
+        recognizers: Pool of warm Vosk recognizers
         
     Returns:
         Recognized text or None if recognition failed
     """
-    # Convert to int16 format required by Vosk
-    audio_int16 = (audio_data * 32767).astype(np.int16)
-    audio_bytes = audio_int16.tobytes()
+    return recognizers.recognize(pcm)
+
+
+def analyze_pipelined(executor: ThreadPoolExecutor, recording: PcmBuffer,
+                      encoder: VoiceEncoder, speakers: SpeakerDatabase,
+                      recognizers: RecognizerPool) -> Tuple[SpeakerMatch, Optional[str]]:
+    """
+    Run authentication and speech recognition on the same buffer in parallel.
     
-    recognizer = KaldiRecognizer(model, sample_rate)
-    recognizer.AcceptWaveform(audio_bytes)
-    result = json.loads(recognizer.FinalResult())
+    Args:
+        executor: Thread pool with at least two workers
+        recording: Recorded audio (float view for auth, int16 for Vosk)
+        encoder: VoiceEncoder instance
+        speakers: Enrolled speakers
+        recognizers: Pool of warm Vosk recognizers
+        
+    Returns:
+        Tuple of (speaker_match, recognized_text).
+        recognized_text is None if authentication failed.
+    """
+    auth_future = executor.submit(authenticate_voice, recording.to_float(), encoder, speakers)
+    asr_future = executor.submit(recognize_speech, recording.pcm, recognizers)
     
-    return result.get('text', '').strip() or None
+    # The command is held until the authentication decision is available
+    match = auth_future.result()
+    if not match.accepted:
+        # The recording buffer is reused for the next window, so recognition
+        # that already started has to finish before it is overwritten
+        if not asr_future.cancel():
+            asr_future.result()
+        return match, None
+    return match, asr_future.result()
 
 
-def process_command(text: str, sock: socket.socket, robot_ip: str, robot_port: int) -> None:
+def process_command(text: str, sock: socket.socket, robot_ip: str, robot_port: int,
+                    speaker: Optional[str] = None,
+                    permissions: Optional[CommandPermissions] = None) -> None:
     """
     Process recognized command and send to robot.
     
@@ -172,40 +260,221 @@ def process_command(text: str, sock: socket.socket, robot_ip: str, robot_port: i
         sock: UDP socket
         robot_ip: Robot IP address
         robot_port: Robot port number
+        speaker: Identified speaker name
+        permissions: Speaker command permissions (None allows everything)
     """
     text_lower = text.lower()
+    denied = False
     
-    for keyword, command in COMMAND_MAPPINGS.items():
+    for keyword, command in COMMAND_KEYWORDS:
         if keyword in text_lower:
+            if permissions is not None and not permissions.allowed(speaker, command):
+                # Keep looking: another keyword in the text may be allowed
+                print(f"DENIED: '{speaker}' may not send '{keyword}' ({command}).")
+                denied = True
+                continue
             send_command(sock, command, robot_ip, robot_port)
             return
     
-    print("Command not recognized.")
+    if not denied:
+        print("Command not recognized.")
+
+
+def run_window_loop(executor: Optional[ThreadPoolExecutor], encoder: VoiceEncoder,
+                    speakers: SpeakerDatabase, recognizers: RecognizerPool,
+                    sock: socket.socket, permissions: CommandPermissions,
+                    speech: Optional[SpeechClient] = None) -> None:
+    """
+    Record fixed RECORDING_DURATION windows and analyze each one.
+    
+    Args:
+        executor: Thread pool for pipelined mode (None otherwise)
+        encoder: VoiceEncoder instance
+        speakers: Enrolled speakers
+        recognizers: Pool of warm Vosk recognizers
+        sock: UDP socket
+        permissions: Speaker command permissions
+        speech: Speech daemon client; replaces executor, encoder, speakers and recognizers
+    """
+    # Recorded as int16 once; reused for every window
+    recording = PcmBuffer(int(RECORDING_DURATION * SAMPLE_RATE))
+    
+    while True:
+        print("\nListening...", end=" ", flush=True)
+        
+        # Step 1: Record audio
+        try:
+            sd.rec(out=recording.frames,
+                   samplerate=SAMPLE_RATE,
+                   device=AUDIO_DEVICE_ID)
+            sd.wait()
+        except Exception as e:
+            print(f"\nMICROPHONE ERROR: {e}")
+            break
+        
+        recording.invalidate()
+        
+        # Step 1.5: Noise filtering
+        rms = recording.rms()
+        if rms < NOISE_THRESHOLD:
+            print(f"(Silence/Noise - Level: {rms:.4f})")
+            continue
+        
+        print(f"Audio Detected ({rms:.4f}) -> Starting Analysis...")
+        analysis_start = time.perf_counter()
+        
+        if speech is not None:
+            # Steps 2+3: Done by the speech daemon (in parallel)
+            match, recognized_text = speech.analyze(recording.pcm)
+            print_identity(match)
+            if not match.accepted:
+                print("DENIED: Unauthorized voice.")
+                continue
+            print("AUTHORIZED.")
+        elif PIPELINED_MODE:
+            # Steps 2+3: Authentication and recognition in parallel
+            match, recognized_text = analyze_pipelined(
+                executor, recording, encoder, speakers, recognizers
+            )
+            print_identity(match)
+            if not match.accepted:
+                print("DENIED: Unauthorized voice.")
+                continue
+            print("AUTHORIZED.")
+        else:
+            # Step 2: Voice authentication
+            match = authenticate_voice(recording.to_float(), encoder, speakers)
+            
+            print_identity(match)
+            
+            if not match.accepted:
+                print("DENIED: Unauthorized voice.")
+                continue
+            
+            # Step 3: Speech recognition
+            print("AUTHORIZED. Recognizing command...")
+            recognized_text = recognize_speech(recording.pcm, recognizers)
+        
+        print(f"Analysis time: {time.perf_counter() - analysis_start:.2f} s")
+        
+        if recognized_text:
+            print(f"COMMAND: '{recognized_text}'")
+            process_command(recognized_text, sock, ROBOT_IP, ROBOT_PORT,
+                            match.name, permissions)
+        else:
+            print("Speech could not be converted to text.")
+
+
+def run_stream_loop(encoder: VoiceEncoder, speakers: SpeakerDatabase,
+                    model: Model, sock: socket.socket,
+                    permissions: CommandPermissions,
+                    speech: Optional[SpeechClient] = None) -> None:
+    """
+    Capture continuously and analyze each utterance as soon as Vosk detects
+    its end. Recognition already happened while the user was speaking; with
+    INCREMENTAL_AUTH so did authentication, otherwise the utterance audio is
+    authenticated after the endpoint.
+    
+    Args:
+        encoder: VoiceEncoder instance
+        speakers: Enrolled speakers
+        model: Vosk model instance
+        sock: UDP socket
+        permissions: Speaker command permissions
+        speech: Speech daemon client; decoding and authentication run there
+    """
+    if speech is not None:
+        decoder = RemoteDecoder(speech)
+    else:
+        from vosk import KaldiRecognizer
+        authenticator = None
+        if INCREMENTAL_AUTH:
+            from incremental_auth import IncrementalAuthenticator
+            # Silent blocks are skipped so they don't dilute the embedding
+            authenticator = IncrementalAuthenticator(encoder, speakers, min_rms=NOISE_THRESHOLD)
+        decoder = UtteranceDecoder(KaldiRecognizer(model, SAMPLE_RATE), authenticator)
+    listener = StreamingListener(decoder, SAMPLE_RATE, device=AUDIO_DEVICE_ID,
+                                 block_ms=STREAM_BLOCK_MS,
+                                 max_utterance_seconds=MAX_UTTERANCE_SECONDS)
+    print("\nListening (streaming)...")
+    
+    with listener:
+        for recognized_text, utterance, match in listener.utterances():
+            rms = calculate_rms(utterance)
+            if rms < NOISE_THRESHOLD:
+                print(f"(Silence/Noise - Level: {rms:.4f}) '{recognized_text}' ignored")
+                continue
+            
+            print(f"Utterance ({len(utterance) / SAMPLE_RATE:.1f} s): '{recognized_text}'")
+            analysis_start = time.perf_counter()
+            
+            if match is None:
+                match = authenticate_voice(utterance, encoder, speakers)
+            print_identity(match)
+            print(f"Analysis time: {time.perf_counter() - analysis_start:.2f} s")
+            
+            if not match.accepted:
+                print("DENIED: Unauthorized voice.")
+                continue
+            
+            print(f"AUTHORIZED. COMMAND: '{recognized_text}'")
+            process_command(recognized_text, sock, ROBOT_IP, ROBOT_PORT,
+                            match.name, permissions)
+    
+    if listener.ring.overruns or listener.status_errors:
+        print(f"Capture: {listener.ring.overruns} samples dropped, "
+              f"{listener.status_errors} input status errors")
+
+
+def connect_speech_daemon() -> Optional[SpeechClient]:
+    """
+    Connect to the speech daemon.
+    
+    Returns:
+        SpeechClient, or None if the daemon is not running
+    """
+    try:
+        speech = SpeechClient(SPEECH_DAEMON_SOCKET)
+        status = speech.ping()
+    except (OSError, SpeechDaemonError) as e:
+        print(f"-> Speech daemon not available ({e}); loading models locally.")
+        return None
+    print(f"-> Using speech daemon at {SPEECH_DAEMON_SOCKET} "
+          f"({status['speakers']} speakers, up {status['uptime']:.0f} s)")
+    return speech
 
 
 def main():
     """Main voice control loop."""
     print("Loading Biometric Security System...")
     
-    # Load voice signature
-    owner_signature = load_voice_signature(SIGNATURE_FILE)
-    
-    # Initialize voice encoder
-    print("-> Loading Resemblyzer (Voice Signature Engine)...")
-    try:
-        encoder = VoiceEncoder()
-    except Exception as e:
-        print(f"Error loading encoder: {e}")
-        sys.exit(1)
+    permissions = CommandPermissions(PERMISSIONS_FILE, COMMAND_MAPPINGS.values(), STOP_COMMAND)
+    speech = connect_speech_daemon() if USE_SPEECH_DAEMON else None
+    speakers = encoder = model = None
     
-    # Initialize Vosk model
-    print("-> Loading Vosk (Speech Recognition Engine)...")
-    try:
-        model = Model(MODEL_PATH)
-    except Exception as e:
-        print(f"Error loading Vosk model: {e}")
-        print(f"Make sure '{MODEL_PATH}' directory exists and contains a valid Vosk model.")
-        sys.exit(1)
+    if speech is None:
+        from resemblyzer import VoiceEncoder
+        from vosk import Model
+        
+        # Load enrolled speakers
+        speakers = load_speakers()
+        
+        # Initialize voice encoder
+        print("-> Loading Resemblyzer (Voice Signature Engine)...")
+        try:
+            encoder = VoiceEncoder()
+        except Exception as e:
+            print(f"Error loading encoder: {e}")
+            sys.exit(1)
+        
+        # Initialize Vosk model
+        print("-> Loading Vosk (Speech Recognition Engine)...")
+        try:
+            model = Model(MODEL_PATH)
+        except Exception as e:
+            print(f"Error loading Vosk model: {e}")
+            print(f"Make sure '{MODEL_PATH}' directory exists and contains a valid Vosk model.")
+            sys.exit(1)
     
     # Initialize UDP socket
     sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
@@ -215,57 +484,37 @@ def main():
     print(f"Microphone: Device ID {AUDIO_DEVICE_ID}")
     print(f"Noise Threshold: {NOISE_THRESHOLD}")
     print(f"Similarity Threshold: {SIMILARITY_THRESHOLD}")
+    print(f"Capture Mode: {CAPTURE_MODE}")
+    print(f"Pipelined Analysis: {'ON' if PIPELINED_MODE else 'OFF'}")
     print("=" * 50)
     
+    executor = None
+    recognizers = None
+    
     try:
-        while True:
-            print("\nListening...", end=" ", flush=True)
-            
-            # Step 1: Record audio
-            try:
-                recording = sd.rec(int(RECORDING_DURATION * SAMPLE_RATE),
-                                  samplerate=SAMPLE_RATE,
-                                  channels=1,
-                                  device=AUDIO_DEVICE_ID)
-                sd.wait()
-            except Exception as e:
-                print(f"\nMICROPHONE ERROR: {e}")
-                break
-            
-            recording = np.squeeze(recording)
-            
-            # Step 1.5: Noise filtering
-            rms = calculate_rms(recording)
-            if rms < NOISE_THRESHOLD:
-                print(f"(Silence/Noise - Level: {rms:.4f})")
-                continue
-            
-            print(f"Audio Detected ({rms:.4f}) -> Starting Analysis...")
-            
-            # Step 2: Voice authentication
-            is_authenticated, similarity = authenticate_voice(
-                recording, encoder, owner_signature, SIMILARITY_THRESHOLD
-            )
-            
-            print(f"Identity Score: {similarity:.2f}")
-            
-            if not is_authenticated:
-                print("DENIED: Unauthorized voice.")
-                continue
-            
-            # Step 3: Speech recognition
-            print("AUTHORIZED. Recognizing command...")
-            recognized_text = recognize_speech(recording, model, SAMPLE_RATE)
-            
-            if recognized_text:
-                print(f"COMMAND: '{recognized_text}'")
-                process_command(recognized_text, sock, ROBOT_IP, ROBOT_PORT)
-            else:
-                print("Speech could not be converted to text.")
-                
+        if CAPTURE_MODE == "stream":
+            run_stream_loop(encoder, speakers, model, sock, permissions, speech)
+        else:
+            # Only the window loop pipelines authentication and recognition
+            if PIPELINED_MODE and speech is None:
+                executor = ThreadPoolExecutor(max_workers=2)
+            if speech is None:
+                from recognizer_pool import RecognizerPool
+                recognizers = RecognizerPool(model, SAMPLE_RATE, size=1)
+            run_window_loop(executor, encoder, speakers, recognizers, sock, permissions, speech)
     except KeyboardInterrupt:
         print("\nSystem shutdown complete.")
+    except (OSError, SpeechDaemonError) as e:
+        if speech is None:
+            raise
+        print(f"\nSpeech daemon error: {e}")
     finally:
+        if recognizers is not None:
+            print(recognizers.report())
+        if executor is not None:
+            executor.shutdown(wait=False)
+        if speech is not None:
+            speech.close()
         sock.close()
 
 
@@ -4,13 +4,20 @@ Voice Enrollment Module
 Records and saves the owner's voice signature for biometric authentication.
 This module is used to create the initial voice profile that will be used
 for authentication in the voice control system.
+
+With --speaker NAME, several recordings are enrolled for that speaker in the
+multi-user speaker database instead (robots shared by several operators).
 """
 
 import sounddevice as sd
 from resemblyzer import VoiceEncoder, preprocess_wav
 import numpy as np
+import argparse
 import os
 import sys
+from typing import Optional
+
+from speaker_db import SpeakerDatabase, INDEX_FILE
 
 # Add parent directory to path for relative imports
 sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
@@ -19,6 +26,9 @@ sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspa
 SAMPLE_RATE = 16000  # Resemblyzer typically uses 16kHz
 RECORDING_DURATION = 30  # Duration in seconds for voice enrollment
 OUTPUT_FILE = os.path.join(os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))), "owner_voice_signature.npy")
+SPEAKER_DB_DIR = os.path.join(os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))), "speaker_db")
+SPEAKER_SAMPLES = 3  # Recordings per speaker in database mode
+SPEAKER_SAMPLE_DURATION = 10  # Seconds per recording in database mode
 
 
 def record_voice(duration: int, sample_rate: int) -> np.ndarray:
@@ -88,8 +98,55 @@ def save_signature(signature: np.ndarray, filepath: str) -> None:
         sys.exit(1)
 
 
+def enroll_speaker(name: str, encoder: VoiceEncoder, samples: int, duration: int,
+                   threshold: Optional[float], db_dir: str) -> None:
+    """
+    Record several samples of a speaker and add them to the speaker database.
+    
+    Args:
+        name: Speaker name
+        encoder: VoiceEncoder instance
+        samples: Number of recordings
+        duration: Duration of each recording in seconds
+        threshold: Acceptance threshold for this speaker (None keeps the existing one)
+        db_dir: Speaker database directory
+    """
+    embeddings = []
+    for i in range(samples):
+        print(f"\nSample {i + 1}/{samples}")
+        audio_data = record_voice(duration, SAMPLE_RATE)
+        embeddings.append(extract_voice_signature(audio_data, encoder))
+    
+    try:
+        if os.path.exists(os.path.join(db_dir, INDEX_FILE)):
+            db = SpeakerDatabase.load(db_dir, mmap=False)
+        else:
+            db = SpeakerDatabase(dim=len(embeddings[0]))
+        db.add(name, np.stack(embeddings), threshold)
+        db.save(db_dir)
+    except Exception as e:
+        print(f"Error saving speaker database: {e}")
+        sys.exit(1)
+    
+    print("=" * 50)
+    print("ENROLLMENT SUCCESSFUL!")
+    print(f"Speaker '{name}' saved to '{db_dir}' ({len(db)} speakers enrolled)")
+    print("=" * 50)
+
+
 def main():
     """Main enrollment function."""
+    parser = argparse.ArgumentParser(description="Voice enrollment")
+    parser.add_argument("--speaker", help="Enroll NAME in the multi-user speaker database")
+    parser.add_argument("--samples", type=int, default=SPEAKER_SAMPLES,
+                        help="Recordings per speaker (database mode)")
+    parser.add_argument("--duration", type=int, default=SPEAKER_SAMPLE_DURATION,
+                        help="Seconds per recording (database mode)")
+    parser.add_argument("--threshold", type=float, default=None,
+                        help="Acceptance threshold for this speaker (database mode, default 0.75)")
+    parser.add_argument("--db", default=SPEAKER_DB_DIR, help="Speaker database directory")
+    args = parser.parse_args()
+    
     print("=" * 50)
     print("Voice Enrollment System")
     print("=" * 50)
@@ -102,6 +159,11 @@ def main():
         print(f"Error loading encoder: {e}")
         sys.exit(1)
     
+    if args.speaker:
+        enroll_speaker(args.speaker, encoder, args.samples, args.duration,
+                       args.threshold, args.db)
+        return
+    
     # Record voice
     audio_data = record_voice(RECORDING_DURATION, SAMPLE_RATE)
     
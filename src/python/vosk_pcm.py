@@ -0,0 +1,46 @@
+"""
+Vosk PCM Input Module
+=====================
+Feeds int16 numpy samples to a Vosk recognizer without copying them.
+
+The zero-copy path uses internals of the vosk Python package: the cffi
+objects vosk._c / vosk._ffi, KaldiRecognizer._handle and the C function
+vosk_recognizer_accept_waveform_s. It follows the package layout of
+vosk 0.3.45 (the minimum in requirements.txt). Any vosk without these
+names uses AcceptWaveform(bytes) instead.
+
+Importing this module loads libvosk, so it is kept out of pcm_buffer.py:
+a speech daemon client never imports it.
+"""
+
+import numpy as np
+
+# Decided once, at import
+try:
+    from vosk import _c as _vosk_lib, _ffi as _vosk_ffi
+    _vosk_lib.vosk_recognizer_accept_waveform_s  # Raises AttributeError if missing
+except (ImportError, AttributeError):
+    _vosk_lib = _vosk_ffi = None
+
+
+def vosk_handles():
+    """Vosk's cffi library and ffi objects, or (None, None) without the zero-copy path."""
+    return _vosk_lib, _vosk_ffi
+
+
+def accept_pcm(recognizer, pcm: np.ndarray) -> bool:
+    """
+    Feed int16 samples to a recognizer without copying them.
+
+    Args:
+        recognizer: Vosk KaldiRecognizer
+        pcm: Contiguous int16 samples
+
+    Returns:
+        True if Vosk detected an endpoint (same as AcceptWaveform)
+    """
+    handle = getattr(recognizer, '_handle', None) if _vosk_ffi is not None else None
+    if handle is not None and pcm.flags['C_CONTIGUOUS']:
+        samples = _vosk_ffi.from_buffer("short[]", pcm)
+        return _vosk_lib.vosk_recognizer_accept_waveform_s(handle, samples, len(pcm)) == 1
+    return recognizer.AcceptWaveform(pcm.tobytes()) == 1